@@ -0,0 +1,32 @@
+/*
+ * allocators.c - Table of the malloc packages that the driver evaluates
+ */
+#include "mm.h"
+#include "allocators.h"
+
+/* Prototypes of a package compiled with its symbols renamed to prefix_* */
+#define DECLARE_PACKAGE(prefix)					\
+    extern team_t prefix##_team;				\
+    extern int prefix##_mm_init(void);				\
+    extern void *prefix##_mm_malloc(size_t size);		\
+    extern void prefix##_mm_free(void *ptr);			\
+    extern void *prefix##_mm_realloc(void *ptr, size_t size)
+
+/* Table entry of a package compiled with its symbols renamed to prefix_* */
+#define PACKAGE(prefix)							\
+    {#prefix, &prefix##_team, prefix##_mm_init, prefix##_mm_malloc,	\
+     prefix##_mm_free, prefix##_mm_realloc}
+
+DECLARE_PACKAGE(explicit);   /* mm_Explicit.c */
+DECLARE_PACKAGE(implicit);   /* mm_Implicit.c */
+DECLARE_PACKAGE(segregated); /* mm_Simple Segregated.c */
+
+allocator_t allocators[] = {
+    {"mm", &team, mm_init, mm_malloc, mm_free, mm_realloc, mm_stats, 
+     mm_walk, mm_check, mm_free_sized, mm_usable_size, mm_malloc_hint,
+     mm_snapshot, mm_restore, mm_malloc_batch, mm_free_batch},
+    PACKAGE(explicit),
+    PACKAGE(implicit),
+    PACKAGE(segregated),
+    {NULL}
+};
@@ -0,0 +1,30 @@
+/*
+ * allocators.h - Table of the malloc packages that the driver evaluates
+ *
+ * Besides mm.c, the driver links the alternative implementations
+ * (mm_Explicit.c, mm_Implicit.c, "mm_Simple Segregated.c"). The
+ * Makefile compiles each of them with its external symbols renamed to
+ * <prefix>_<symbol>, so they can all live in the same executable.
+ */
+
+typedef struct {
+    char *name;                              /* short name for reports */
+    team_t *team;                            /* the package's team struct */
+    int (*init)(void);                       /* mm_init */
+    void *(*malloc)(size_t size);            /* mm_malloc */
+    void (*free)(void *ptr);                 /* mm_free */
+    void *(*realloc)(void *ptr, size_t size);/* mm_realloc */
+    void (*stats)(mm_stats_t *st);           /* mm_stats (NULL: none) */
+    void (*walk)(mm_walk_fn fn, void *arg);  /* mm_walk (NULL: none) */
+    int (*check)(int full, int verbose);     /* mm_check (NULL: none) */
+    void (*free_sized)(void *ptr, size_t size); /* mm_free_sized (NULL: none) */
+    size_t (*usable_size)(void *ptr);        /* mm_usable_size (NULL: none) */
+    void *(*malloc_hint)(size_t size, int hint); /* mm_malloc_hint (NULL: none) */
+    int (*snapshot)(void);                   /* mm_snapshot (NULL: none) */
+    void (*restore)(void);                   /* mm_restore (NULL: none) */
+    int (*malloc_batch)(size_t size, int n, void **ptrs); /* mm_malloc_batch (NULL: none) */
+    void (*free_batch)(void **ptrs, int n);  /* mm_free_batch (NULL: none) */
+} allocator_t;
+
+/* The registered packages. mm.c comes first; a NULL name ends the table */
+extern allocator_t allocators[];
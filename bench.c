@@ -0,0 +1,239 @@
+/*
+ * bench.c - robust timing of a test function over repeated samples
+ *
+ * Each sample is a single run of f, timed with read_counter(). Unlike
+ * a K-best scheme, which reports the fastest runs, bench_run
+ * reports the median of all runs. It also reports how much the runs
+ * spread, which the driver needs to tell a real regression from noise.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+#include "clock.h"
+
+#define WARM_WINDOW 3    /* runs per warmup window */
+#define WARM_EPS 0.02    /* two windows this close => time has settled */
+#define MAD_SIGMA 1.4826 /* MAD to standard deviation, for normal data */
+
+/* qsort comparison function for doubles */
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(double *)a, y = *(double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Median of the n values in v (sorts v as a side effect) */
+static double median(double *v, int n)
+{
+    qsort(v, n, sizeof(double), cmp_double);
+    return (n % 2) ? v[n/2] : (v[n/2 - 1] + v[n/2]) / 2.0;
+}
+
+/* faults_now - Page faults (minor and major) of this process so far */
+static long faults_now(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt + ru.ru_majflt;
+}
+
+/*
+ * time1 - Run the setup hook, then time a single run of f(argp) in 
+ *     secs, and count the page faults that it took
+ */
+static double time1(bench_funct f, void *argp, bench_params_t *p,
+		    long *faults)
+{
+    unsigned long long start, end;
+    double mhz = counter_mhz(); /* calibrates on the first call */
+    long f0;
+
+    if (p->setup)
+	p->setup(argp);
+    f0 = faults_now();
+    start = read_counter();
+    f(argp);
+    end = read_counter();
+    *faults = faults_now() - f0;
+    return (end - start) / (mhz * 1e6);
+}
+
+/*
+ * time1_forked - Like time1, but run the setup hook and f in a child
+ *     process that is forked from the caller's current state and sends
+ *     the time back through a pipe. f then can't leave anything behind
+ *     for the next run: every run starts from the same heap and page
+ *     mappings, and pays the same copy-on-write faults for the pages
+ *     that it writes.
+ */
+static double time1_forked(bench_funct f, void *argp, bench_params_t *p,
+			   long *faults)
+{
+    int fd[2], status;
+    struct { double secs; long faults; } res;
+    pid_t pid;
+
+    counter_mhz();  /* calibrate once, in the parent, not in every child */
+    fflush(stdout); /* or the child's exit could print it again */
+    if (pipe(fd) < 0 || (pid = fork()) < 0) {
+	fprintf(stderr, "bench: fork failed: %s\n", strerror(errno));
+	exit(1);
+    }
+    if (pid == 0) {
+	close(fd[0]);
+	res.secs = time1(f, argp, p, &res.faults);
+	if (write(fd[1], &res, sizeof(res)) != sizeof(res))
+	    _exit(1);
+	_exit(0);
+    }
+    close(fd[1]);
+    if (read(fd[0], &res, sizeof(res)) != sizeof(res))
+	res.secs = -1;
+    close(fd[0]);
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || 
+	WEXITSTATUS(status) != 0 || res.secs < 0) {
+	fprintf(stderr, "bench: a forked run failed\n");
+	exit(1);
+    }
+    *faults = res.faults;
+    return res.secs;
+}
+
+/*
+ * warmup - Run f until the median of the last WARM_WINDOW runs is
+ *     within WARM_EPS of the median of the WARM_WINDOW runs before
+ *     them, or until max_warmup runs. Returns the number of runs.
+ */
+static int warmup(bench_funct f, void *argp, bench_params_t *p)
+{
+    double *t, w[WARM_WINDOW], old, new;
+    long faults;
+    int n;
+
+    t = (double *)malloc((p->max_warmup + 1) * sizeof(double));
+    if (t == NULL) {
+	fprintf(stderr, "bench: malloc failed in warmup\n");
+	exit(1);
+    }
+    for (n = 0; n < p->max_warmup; ) {
+	t[n++] = p->isolate ? time1_forked(f, argp, p, &faults) : 
+	    time1(f, argp, p, &faults);
+	if (n < 2 * WARM_WINDOW)
+	    continue;
+	memcpy(w, &t[n - 2*WARM_WINDOW], sizeof(w));
+	old = median(w, WARM_WINDOW);
+	memcpy(w, &t[n - WARM_WINDOW], sizeof(w));
+	new = median(w, WARM_WINDOW);
+	if (fabs(new - old) <= WARM_EPS * old)
+	    break;
+    }
+    free(t);
+    return n;
+}
+
+/*
+ * summarize - Compute the statistics of the n samples in t, after
+ *     dropping the outliers. tmp is scratch space for n doubles.
+ */
+static void summarize(double *t, int n, double *tmp, bench_params_t *p,
+		      bench_result_t *r)
+{
+    double med, mad, sum = 0, sumsq = 0;
+    int i, k, lo, hi;
+
+    /* Median and MAD of all samples */
+    memcpy(tmp, t, n * sizeof(double));
+    med = median(tmp, n);
+    for (i = 0; i < n; i++)
+	tmp[i] = fabs(t[i] - med);
+    mad = median(tmp, n);
+
+    /* Keep the samples within outlier_mads (scaled) MADs of the median */
+    for (i = 0, k = 0; i < n; i++)
+	if (fabs(t[i] - med) <= p->outlier_mads * MAD_SIGMA * mad)
+	    tmp[k++] = t[i];
+    if (k == 0) {  /* mad == 0 and no sample is exactly the median */
+	memcpy(tmp, t, n * sizeof(double));
+	k = n;
+    }
+    r->outliers = n - k;
+    r->samples = k;
+
+    /* The distribution-free CI of the median uses order statistics */
+    r->median = median(tmp, k);
+    lo = (int)floor(k / 2.0 - 0.98 * sqrt(k));
+    hi = (int)ceil(k / 2.0 + 0.98 * sqrt(k));
+    r->lo = tmp[lo < 0 ? 0 : lo];
+    r->hi = tmp[hi > k-1 ? k-1 : hi];
+
+    for (i = 0; i < k; i++) {
+	sum += tmp[i];
+	sumsq += tmp[i] * tmp[i];
+    }
+    r->mean = sum / k;
+    r->sd = (k > 1) ? sqrt(fmax(0.0, (sumsq - sum * sum / k) / (k - 1))) : 0;
+    for (i = 0; i < k; i++)
+	tmp[i] = fabs(tmp[i] - r->median);
+    r->mad = median(tmp, k);
+}
+
+/*
+ * bench_init - Fill in the default parameters
+ */
+void bench_init(bench_params_t *p)
+{
+    p->min_samples = BENCH_MIN_SAMPLES;
+    p->max_samples = BENCH_MAX_SAMPLES;
+    p->max_warmup = BENCH_MAX_WARMUP;
+    p->target_ci = BENCH_TARGET_CI;
+    p->outlier_mads = BENCH_OUTLIER_MADS;
+    p->setup = NULL;
+    p->isolate = 0;
+}
+
+/*
+ * bench_run - Warm up, then take samples of f(argp) until the CI of
+ *     the median is below target_ci of the median (but at least
+ *     min_samples and at most max_samples of them)
+ */
+void bench_run(bench_funct f, void *argp, bench_params_t *p,
+	       bench_result_t *r)
+{
+    double *t, *tmp;
+    long faults, total = 0;
+    int n = 0, max = p->max_samples;
+
+    if (max < p->min_samples)
+	max = p->min_samples;
+    if (max < 1)
+	max = 1;
+    if ((t = (double *)malloc(2 * max * sizeof(double))) == NULL) {
+	fprintf(stderr, "bench: malloc failed in bench_run\n");
+	exit(1);
+    }
+    tmp = t + max;
+
+    r->warmup = warmup(f, argp, p);
+    while (n < max) {
+	t[n++] = p->isolate ? time1_forked(f, argp, p, &faults) : 
+	    time1(f, argp, p, &faults);
+	total += faults;
+	if (n < p->min_samples)
+	    continue;
+	summarize(t, n, tmp, p, r);
+	if ((r->hi - r->lo) / 2 <= p->target_ci * r->median)
+	    break;
+    }
+    r->faults = (double)total / n;
+    free(t);
+}
@@ -0,0 +1,56 @@
+/*
+ * bench.h - robust timing of a test function over repeated samples
+ *
+ * bench_run times single runs of f with the cycle counter (see clock.c).
+ * It first discards warmup runs until the running time has settled. It
+ * then takes samples until the 95% confidence interval of the median is
+ * tight enough, and drops outliers by their distance from the median in
+ * units of the median absolute deviation (MAD).
+ */
+
+/* The test function takes a generic pointer as input */
+typedef void (*bench_funct)(void *);
+
+/* Defaults of the bench_params_t fields */
+#define BENCH_MIN_SAMPLES 10     /* samples taken before checking the CI */
+#define BENCH_MAX_SAMPLES 200    /* give up on the CI target after these */
+#define BENCH_MAX_WARMUP  20     /* warmup runs before taking samples anyway */
+#define BENCH_TARGET_CI   0.005  /* CI half-width, relative to the median */
+#define BENCH_OUTLIER_MADS 5.0   /* samples further out are outliers */
+
+typedef struct {
+    int min_samples;     /* take at least this many samples */
+    int max_samples;     /* and at most this many */
+    int max_warmup;      /* at most this many warmup runs */
+    double target_ci;    /* stop when the CI half-width/median is below */
+    double outlier_mads; /* outlier distance from the median, in MADs */
+
+    /* If not NULL, called with argp before every run, outside the timing */
+    bench_funct setup;
+
+    /*
+     * If set, every run (and its setup) happens in a child process
+     * forked from the caller, so that the runs can't change the state
+     * that the next one starts from
+     */
+    int isolate;
+} bench_params_t;
+
+typedef struct {
+    int warmup;          /* number of warmup runs that were discarded */
+    int samples;         /* number of samples that were kept */
+    int outliers;        /* number of samples rejected as outliers */
+    double median;       /* median running time of the kept samples (secs) */
+    double mad;          /* their median absolute deviation (secs) */
+    double mean;         /* their mean (secs) */
+    double sd;           /* their standard deviation (secs) */
+    double lo, hi;       /* 95% confidence interval of the median (secs) */
+    double faults;       /* page faults per sample (minor and major) */
+} bench_result_t;
+
+/* Fill in the default parameters */
+void bench_init(bench_params_t *p);
+
+/* Time f(argp) as described above and store the statistics in r */
+void bench_run(bench_funct f, void *argp, bench_params_t *p,
+	       bench_result_t *r);
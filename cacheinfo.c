@@ -0,0 +1,197 @@
+/*
+ * cacheinfo.c - cache topology of the host and cache eviction
+ */
+#define _GNU_SOURCE     /* for sched_getcpu */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include "cacheinfo.h"
+
+#define DEFAULT_LINE 64           /* line size if we can't find out */
+#define DEFAULT_LLC (32 << 20)    /* LLC size if we can't find out */
+
+/* The cache hierarchy, read once by load_caches */
+static cache_t caches_buf[MAX_CACHES];
+static int ncaches = -1;
+
+/* Buffer that cache_evict sweeps */
+static volatile char *evict_buf = NULL;
+static size_t evict_bytes = 0;
+static volatile long sink = 0;
+
+/*
+ * read_sysfs - Read the first line of a sysfs file into buf. Returns 0
+ *     if the file doesn't exist.
+ */
+static int read_sysfs(char *path, char *buf, int len)
+{
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL)
+	return 0;
+    if (fgets(buf, len, fp) == NULL) {
+	fclose(fp);
+	return 0;
+    }
+    fclose(fp);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 1;
+}
+
+/*
+ * load_sysfs - Read the caches of one CPU from sysfs
+ */
+static int load_sysfs(int cpu)
+{
+    char dir[128], path[160], buf[64];
+    char *suffix;
+    int i, n = 0;
+
+    for (i = 0; n < MAX_CACHES; i++) {
+	sprintf(dir, "/sys/devices/system/cpu/cpu%d/cache/index%d", cpu, i);
+	sprintf(path, "%s/level", dir);
+	if (!read_sysfs(path, buf, sizeof(buf)))
+	    break;
+	caches_buf[n].level = atoi(buf);
+	sprintf(path, "%s/type", dir);
+	if (!read_sysfs(path, caches_buf[n].type, sizeof(caches_buf[n].type)))
+	    strcpy(caches_buf[n].type, "Unified");
+	sprintf(path, "%s/size", dir);
+	if (!read_sysfs(path, buf, sizeof(buf)))
+	    continue;
+	caches_buf[n].size = strtoul(buf, &suffix, 10);
+	if (*suffix == 'K')
+	    caches_buf[n].size <<= 10;
+	else if (*suffix == 'M')
+	    caches_buf[n].size <<= 20;
+	sprintf(path, "%s/coherency_line_size", dir);
+	caches_buf[n].line = read_sysfs(path, buf, sizeof(buf)) ?
+	    atoi(buf) : DEFAULT_LINE;
+	n++;
+    }
+    return n;
+}
+
+/*
+ * load_caches - Find the cache hierarchy of the CPU we are running on
+ */
+static void load_caches(void)
+{
+    int cpu = 0;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+
+#ifdef __linux__
+    if ((cpu = sched_getcpu()) < 0)
+	cpu = 0;
+#endif
+    if ((ncaches = load_sysfs(cpu)) > 0)
+	return;
+
+    /* No sysfs: ask the C library, and fall back to a generous LLC */
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    if (line <= 0)
+	line = DEFAULT_LINE;
+    if (l1 > 0) {
+	caches_buf[ncaches].level = 1;
+	strcpy(caches_buf[ncaches].type, "Data");
+	caches_buf[ncaches].size = l1;
+	caches_buf[ncaches++].line = line;
+    }
+    if (l2 > 0) {
+	caches_buf[ncaches].level = 2;
+	strcpy(caches_buf[ncaches].type, "Unified");
+	caches_buf[ncaches].size = l2;
+	caches_buf[ncaches++].line = line;
+    }
+    if (l3 > 0) {
+	caches_buf[ncaches].level = 3;
+	strcpy(caches_buf[ncaches].type, "Unified");
+	caches_buf[ncaches].size = l3;
+	caches_buf[ncaches++].line = line;
+    }
+#endif
+    if (ncaches == 0) {
+	caches_buf[0].level = 1;
+	strcpy(caches_buf[0].type, "Unified");
+	caches_buf[0].size = DEFAULT_LLC;
+	caches_buf[0].line = DEFAULT_LINE;
+	ncaches = 1;
+    }
+}
+
+/*
+ * cache_levels - Store the caches of the current CPU in caches[]
+ */
+int cache_levels(cache_t *caches, int max)
+{
+    int n;
+
+    if (ncaches < 0)
+	load_caches();
+    n = (ncaches < max) ? ncaches : max;
+    memcpy(caches, caches_buf, n * sizeof(cache_t));
+    return n;
+}
+
+/*
+ * cache_line_size - Size of the largest data cache line
+ */
+int cache_line_size(void)
+{
+    int i, line = 0;
+
+    if (ncaches < 0)
+	load_caches();
+    for (i = 0; i < ncaches; i++)
+	if (strcmp(caches_buf[i].type, "Instruction") &&
+	    caches_buf[i].line > line)
+	    line = caches_buf[i].line;
+    return line ? line : DEFAULT_LINE;
+}
+
+/*
+ * cache_evict_size - Bytes to sweep to flush all data caches
+ */
+size_t cache_evict_size(void)
+{
+    size_t total = 0;
+    int i;
+
+    if (ncaches < 0)
+	load_caches();
+    for (i = 0; i < ncaches; i++)
+	if (strcmp(caches_buf[i].type, "Instruction"))
+	    total += caches_buf[i].size;
+    return total + total / 2;
+}
+
+/*
+ * cache_evict - Evict the data caches. The buffer is allocated and
+ *     touched on the first call, so later calls don't page fault.
+ */
+void cache_evict(void)
+{
+    size_t i, line = cache_line_size();
+    long x = sink;
+
+    if (evict_buf == NULL) {
+	evict_bytes = cache_evict_size();
+	if ((evict_buf = malloc(evict_bytes)) == NULL) {
+	    fprintf(stderr, "cache_evict: malloc of %lu bytes failed\n",
+		    (unsigned long)evict_bytes);
+	    exit(1);
+	}
+	memset((char *)evict_buf, 1, evict_bytes);
+    }
+    for (i = 0; i < evict_bytes; i += line)
+	x += evict_buf[i];
+    sink = x;
+}
@@ -0,0 +1,34 @@
+/*
+ * cacheinfo.h - cache topology of the host and cache eviction
+ *
+ * The topology comes from /sys/devices/system/cpu/cpuN/cache on Linux
+ * (for the CPU we are running on), then from sysconf, and otherwise
+ * from conservative defaults.
+ */
+#include <stddef.h>
+
+#define MAX_CACHES 8
+
+/* One cache of the hierarchy */
+typedef struct {
+    int level;           /* 1 = L1, 2 = L2, ... */
+    char type[16];       /* "Data", "Instruction" or "Unified" */
+    size_t size;         /* capacity in bytes */
+    int line;            /* line size in bytes */
+} cache_t;
+
+/* Store the caches of the current CPU in caches[] and return their number */
+int cache_levels(cache_t *caches, int max);
+
+/* Size of the largest cache line of the data caches */
+int cache_line_size(void);
+
+/*
+ * cache_evict_size - Number of bytes that cache_evict sweeps: half again
+ *     the total capacity of all data and unified caches, which flushes
+ *     inclusive and exclusive hierarchies alike
+ */
+size_t cache_evict_size(void);
+
+/* Evict the data caches by reading one word of every line of a buffer */
+void cache_evict(void);
@@ -10,22 +10,32 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/times.h>
+#include <time.h>
 #include "clock.h"
 
+/* Not every libc knows the raw (NTP-free) monotonic clock */
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
 
 /******************************************************* 
  * Machine dependent functions 
  *
- * Note: the constants __i386__ and  __alpha
+ * Note: the constants __i386__, __x86_64__ and __alpha
  * are set by GCC when it calls the C preprocessor
  * You can verify this for yourself using gcc -v.
  *******************************************************/
 
-#if defined(__i386__)  
+#if defined(__i386__) || defined(__x86_64__)
 /*******************************************************
- * Pentium versions of start_counter() and get_counter()
+ * Pentium and x86-64 versions of start_counter() and get_counter()
  *******************************************************/
 
+#include <cpuid.h>
+
+/* Does the CPU have rdtscp? (-1 until we have asked cpuid) */
+static int have_rdtscp = -1;
 
 /* $begin x86cyclecounter */
 /* Initialize the cycle counter */
@@ -34,13 +44,23 @@ static unsigned cyc_lo = 0;
 
 
 /* Set *hi and *lo to the high and low order bits  of the cycle counter.  
-   Implementation requires assembly code to use the rdtsc instruction. */
+   Implementation requires assembly code to use the rdtsc instruction.
+   rdtscp waits for all earlier instructions to finish before it reads
+   the counter, and the lfence keeps later ones from starting before
+   it, so the timed code can't leak out of the measured interval. */
 void access_counter(unsigned *hi, unsigned *lo)
 {
-    asm("rdtsc; movl %%edx,%0; movl %%eax,%1"   /* Read cycle counter */
-	: "=r" (*hi), "=r" (*lo)                /* and move results to */
-	: /* No input */                        /* the two outputs */
-	: "%edx", "%eax");
+    unsigned a, b, c, d;
+
+    if (have_rdtscp < 0)
+	have_rdtscp = __get_cpuid(0x80000001, &a, &b, &c, &d) &&
+	    (d & (1 << 27));
+    if (have_rdtscp)
+	asm volatile("rdtscp; lfence"
+		     : "=d" (*hi), "=a" (*lo) : : "%ecx", "memory");
+    else
+	asm volatile("lfence; rdtsc; lfence"
+		     : "=d" (*hi), "=a" (*lo) : : "memory");
 }
 
 /* Record the current value of the cycle counter. */
@@ -71,6 +91,28 @@ double get_counter()
 }
 /* $end x86cyclecounter */
 
+/* Return the raw 64-bit value of the cycle counter */
+unsigned long long read_counter()
+{
+    unsigned hi, lo;
+
+    access_counter(&hi, &lo);
+    return ((unsigned long long) hi << 32) | lo;
+}
+
+/* 
+ * Does the counter tick at a constant rate, independent of power
+ * states and frequency scaling? (CPUID "invariant TSC" bit)
+ */
+int counter_invariant()
+{
+    unsigned a, b, c, d;
+
+    return __get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1 << 8));
+}
+
+#define HAVE_CYCLE_COUNTER 1
+
 #elif defined(__alpha)
 
 /****************************************************
@@ -133,6 +175,20 @@ double get_counter()
     return result;
 }
 
+/* Return the raw value of the (32-bit) cycle counter */
+unsigned long long read_counter()
+{
+    return counter();
+}
+
+/* The Alpha cycle counter follows the clock rate */
+int counter_invariant()
+{
+    return 0;
+}
+
+#define HAVE_CYCLE_COUNTER 1
+
 #else
 
 /****************************************************************
@@ -158,6 +214,26 @@ double get_counter()
     printf("Please choose another timing package in config.h.\n");
     exit(1);
 }
+
+/* 
+ * Without a cycle counter, read_counter() falls back to the
+ * monotonic clock, so its "ticks" are nanoseconds.
+ */
+unsigned long long read_counter()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The monotonic clock always runs at a constant rate */
+int counter_invariant()
+{
+    return 1;
+}
+
+#define HAVE_CYCLE_COUNTER 0
 #endif
 
 
@@ -201,6 +277,62 @@ double mhz(int verbose)
     return mhz_full(verbose, 2);
 }
 
+/* Rate of read_counter() ticks in MHz (0 until it has been measured) */
+static double counter_rate = 0.0;
+
+#define CAL_RUNS 5           /* number of calibration windows */
+#define CAL_NSECS 10e6       /* length of each window (10 ms) */
+
+/* Current value of the raw monotonic clock, in nanoseconds */
+static double mono_nsecs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * mhz_calibrate - Estimate the counter rate by spinning for CAL_RUNS
+ *     short windows of the raw monotonic clock and taking the median.
+ *     This takes a few tens of ms instead of mhz()'s two seconds, and
+ *     since the CPU stays busy it can't drop into a slower power state
+ *     in the middle of a measurement.
+ */
+double mhz_calibrate(int verbose)
+{
+    double rates[CAL_RUNS], t0, t, rate;
+    unsigned long long c0, c;
+    int i, j;
+
+    for (i = 0; i < CAL_RUNS; i++) {
+	t0 = mono_nsecs();
+	c0 = read_counter();
+	while ((t = mono_nsecs()) - t0 < CAL_NSECS)
+	    ;
+	c = read_counter();
+	rate = (c - c0) * 1e3 / (t - t0);
+
+	/* Insert into the sorted prefix of rates */
+	for (j = i; j > 0 && rates[j-1] > rate; j--)
+	    rates[j] = rates[j-1];
+	rates[j] = rate;
+    }
+    counter_rate = rates[CAL_RUNS / 2];
+    if (verbose) 
+	printf("Counter rate ~= %.1f MHz (%s)\n", counter_rate,
+	       counter_invariant() ? "invariant" : "may vary with clock speed");
+    return counter_rate;
+}
+
+/* Rate of read_counter() ticks in MHz (measured once, then cached) */
+double counter_mhz()
+{
+    if (counter_rate == 0.0)
+	counter_rate = HAVE_CYCLE_COUNTER ? mhz_calibrate(0) : 1000.0;
+    return counter_rate;
+}
+
 /** Special counters that compensate for timer interrupt overhead */
 
 static double cyc_per_tick = 0.0;
@@ -6,6 +6,15 @@ void start_counter();
 /* Get # cycles since counter started */
 double get_counter();
 
+/* Read the raw counter, for fine-grained (per-operation) timing */
+unsigned long long read_counter();
+
+/* Rate of read_counter() ticks in MHz */
+double counter_mhz();
+
+/* Does the counter tick at a constant rate? (e.g., invariant TSC) */
+int counter_invariant();
+
 /* Measure overhead for counter */
 double ovhd();
 
@@ -15,6 +24,9 @@ double mhz(int verbose);
 /* Determine clock rate of processor, having more control over accuracy */
 double mhz_full(int verbose, int sleeptime);
 
+/* Determine counter rate quickly against the raw monotonic clock */
+double mhz_calibrate(int verbose);
+
 /** Special counters that compensate for timer interrupt overhead */
 
 void start_comp_counter();
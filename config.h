@@ -52,6 +52,15 @@
   */
 #define UTIL_WEIGHT .60
 
+/*
+ * Regression thresholds for the driver's baseline comparison (-b). A
+ * trace regresses if its utilization drops by more than REGRESS_UTIL
+ * (absolute), or if its throughput drops by more than REGRESS_THRU
+ * (relative) and the 95% confidence interval of the change excludes 0.
+ */
+#define REGRESS_UTIL 0.005   /* half a percentage point */
+#define REGRESS_THRU 0.01    /* 1% */
+
 /* 
  * Alignment requirement in bytes (either 4 or 8) 
  */
@@ -62,11 +71,4 @@
  */
 #define MAX_HEAP (20*(1<<20))  /* 20 MB */
 
-/*****************************************************************************
- * Set exactly one of these USE_xxx constants to "1" to select a timing method
- *****************************************************************************/
-#define USE_FCYC   0   /* cycle counter w/K-best scheme (x86 & Alpha only) */
-#define USE_ITIMER 0   /* interval timer (any Unix box) */
-#define USE_GETTOD 1   /* gettimeofday (any Unix box) */
-
 #endif /* __CONFIG_H */
@@ -0,0 +1,173 @@
+/*
+ * heapmap.c - fragmentation analysis and heap maps from a heap walk
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "heapmap.h"
+
+/* Size class of a free block of size bytes (same bounds as mm.c) */
+static int size_class(size_t size)
+{
+    size_t limit = 16;
+    int i;
+
+    for (i = 0; i < HM_NCLASSES - 1; i++, limit <<= 1)
+	if (size <= limit)
+	    return i;
+    return HM_NCLASSES - 1;
+}
+
+/* add_range - Add the len bytes at start to the cells of map */
+static void add_range(heapmap_t *hm, double *map, char *start, size_t len)
+{
+    size_t off = start - hm->lo, end = off + len, next;
+    int c;
+
+    while (off < end) {
+	c = off / hm->cell;
+	if (c >= HM_WIDTH)
+	    break;
+	next = (c + 1) * hm->cell;
+	if (next > end)
+	    next = end;
+	map[c] += next - off;
+	off = next;
+    }
+}
+
+/*
+ * hm_init - Start a new sample
+ */
+void hm_init(heapmap_t *hm, void *lo, size_t heap, size_t maxheap)
+{
+    memset(hm, 0, sizeof(heapmap_t));
+    hm->lo = (char *)lo;
+    hm->heap = heap;
+    if (maxheap < heap)
+	maxheap = heap;
+    hm->cell = (maxheap + HM_WIDTH - 1) / HM_WIDTH;
+    if (hm->cell == 0)
+	hm->cell = 1;
+}
+
+/*
+ * hm_block - Record a block of the heap walk
+ */
+void hm_block(void *blk, size_t size, int alloc, void *arg)
+{
+    heapmap_t *hm = (heapmap_t *)arg;
+    int c;
+
+    if (alloc) {
+	hm->nalloc++;
+	hm->alloc_bytes += size;
+	return;
+    }
+    hm->nfree++;
+    hm->free_bytes += size;
+    if (size > hm->largest_free)
+	hm->largest_free = size;
+    c = size_class(size);
+    hm->class_free[c]++;
+    hm->class_bytes[c] += size;
+    add_range(hm, hm->map_free, blk, size);
+}
+
+/*
+ * hm_payload - Record the payload of a live block
+ */
+void hm_payload(heapmap_t *hm, void *p, size_t size)
+{
+    hm->payload += size;
+    add_range(hm, hm->map_payload, p, size);
+}
+
+/*
+ * hm_print - Print the fragmentation summary of a sample
+ */
+void hm_print(heapmap_t *hm)
+{
+    double heap = hm->heap ? (double)hm->heap : 1.0;
+    size_t overhead = hm->heap - hm->alloc_bytes - hm->free_bytes;
+    size_t limit = 16;
+    int i;
+
+    printf("  heap %lu bytes: %.1f%% payload, %.1f%% internal frag, "
+	   "%.1f%% free, %.1f%% overhead\n", (unsigned long)hm->heap,
+	   100.0 * hm->payload / heap,
+	   100.0 * (hm->alloc_bytes - hm->payload) / heap,
+	   100.0 * hm->free_bytes / heap, 100.0 * overhead / heap);
+    printf("  %lu allocated and %lu free blocks, largest free %lu bytes "
+	   "(external frag %.2f)\n", hm->nalloc, hm->nfree,
+	   (unsigned long)hm->largest_free, hm->free_bytes ?
+	   1.0 - (double)hm->largest_free / hm->free_bytes : 0.0);
+    if (hm->nfree == 0)
+	return;
+    printf("  %5s%9s%9s%11s\n", "class", "limit", "free", "free bytes");
+    for (i = 0; i < HM_NCLASSES; i++, limit <<= 1) {
+	if (hm->class_free[i] == 0)
+	    continue;
+	if (i < HM_NCLASSES - 1)
+	    printf("  %5d%9lu", i, (unsigned long)limit);
+	else
+	    printf("  %5d%9s", i, "-");
+	printf("%9lu%11lu\n", hm->class_free[i],
+	       (unsigned long)hm->class_bytes[i]);
+    }
+}
+
+/*
+ * covered - Number of bytes of cell c that lie inside the heap
+ */
+static double covered(heapmap_t *hm, int c)
+{
+    size_t start = (size_t)c * hm->cell;
+
+    if (start >= hm->heap)
+	return 0.0;
+    return (hm->heap - start < hm->cell) ? hm->heap - start : hm->cell;
+}
+
+/*
+ * hm_write_text - Write one row of the heap map as text
+ */
+void hm_write_text(FILE *fp, heapmap_t *hm)
+{
+    double in, other;
+    int c;
+
+    for (c = 0; c < HM_WIDTH; c++) {
+	in = covered(hm, c);
+	other = in - hm->map_payload[c] - hm->map_free[c];
+	if (in == 0.0)
+	    fputc(' ', fp);
+	else if (hm->map_free[c] > hm->map_payload[c] &&
+		 hm->map_free[c] > other)
+	    fputc('.', fp);
+	else if (other > hm->map_payload[c])
+	    fputc('+', fp);
+	else
+	    fputc('#', fp);
+    }
+    fputc('\n', fp);
+}
+
+/*
+ * hm_write_pgm - Write one row of the heap map as PGM gray levels.
+ *     Cells beyond the end of the heap are white.
+ */
+void hm_write_pgm(FILE *fp, heapmap_t *hm)
+{
+    double in, other;
+    int c, gray;
+
+    for (c = 0; c < HM_WIDTH; c++) {
+	in = covered(hm, c);
+	other = in - hm->map_payload[c] - hm->map_free[c];
+	gray = (int)((255 * (hm->map_free[c] + hm->cell - in) + 128 * other)
+		     / hm->cell + 0.5);
+	fprintf(fp, "%d%c", gray > 255 ? 255 : gray,
+		c == HM_WIDTH - 1 ? '\n' : ' ');
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * heapmap.h - fragmentation analysis and heap maps from a heap walk
+ *
+ * The allocator's heap walker (e.g., mm_walk) calls hm_block for each
+ * block. The driver then calls hm_payload for each live block, because
+ * only it knows how many bytes were requested. The result splits the
+ * heap into payload, internal fragmentation (allocated but unrequested
+ * bytes), free blocks and the allocator's fixed overhead, and can be
+ * drawn as one row of a heap map.
+ */
+#include <stdio.h>
+#include <stddef.h>
+
+#define HM_NCLASSES 12       /* power-of-two size classes of free blocks */
+#define HM_WIDTH 128         /* cells per heap map row */
+
+typedef struct {
+    size_t heap;             /* heap size when the sample was taken */
+    size_t payload;          /* bytes requested by the live blocks */
+    size_t alloc_bytes;      /* total size of the allocated blocks */
+    size_t free_bytes;       /* total size of the free blocks */
+    size_t largest_free;     /* size of the largest free block */
+    unsigned long nalloc;    /* number of allocated blocks */
+    unsigned long nfree;     /* number of free blocks */
+
+    /* Free blocks by size class: class i holds sizes in
+       (16 << (i-1), 16 << i], and the last class everything larger */
+    unsigned long class_free[HM_NCLASSES];
+    size_t class_bytes[HM_NCLASSES];
+
+    /* Heap map: payload and free bytes in each of HM_WIDTH cells of
+       size cell, covering the heap from lo on. The rest of a cell is
+       fragmentation or overhead. */
+    char *lo;
+    size_t cell;
+    double map_payload[HM_WIDTH];
+    double map_free[HM_WIDTH];
+} heapmap_t;
+
+/*
+ * hm_init - Start a new sample of a heap that starts at lo and is
+ *     heap bytes large now, drawn at a scale for a heap of maxheap bytes
+ */
+void hm_init(heapmap_t *hm, void *lo, size_t heap, size_t maxheap);
+
+/* Record a block of the heap walk (arg is the heapmap_t) */
+void hm_block(void *blk, size_t size, int alloc, void *arg);
+
+/* Record the payload of a live block */
+void hm_payload(heapmap_t *hm, void *p, size_t size);
+
+/* Print the fragmentation summary of a sample */
+void hm_print(heapmap_t *hm);
+
+/*
+ * hm_write_text - Write one row of the heap map as text: '#' for cells
+ *     that are mostly payload, '+' for mostly internal fragmentation or
+ *     overhead, '.' for mostly free and ' ' beyond the end of the heap
+ */
+void hm_write_text(FILE *fp, heapmap_t *hm);
+
+/*
+ * hm_write_pgm - Write one row of the heap map as HM_WIDTH gray levels
+ *     of a plain PGM image: payload is black, free space white and
+ *     fragmentation/overhead mid gray, mixed by their share of a cell
+ */
+void hm_write_pgm(FILE *fp, heapmap_t *hm);
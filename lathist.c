@@ -0,0 +1,112 @@
+/*
+ * lathist.c - log-linear (HDR-style) latency histograms
+ *
+ * Bucket layout: values below LH_SUB get a bucket of their own. A value
+ * v in [2^k, 2^(k+1)) with k >= LH_SUB_BITS is shifted right by
+ * k - LH_SUB_BITS, which leaves LH_SUB_BITS+1 significant bits, and the
+ * low LH_SUB_BITS of those select one of LH_SUB sub-buckets in octave k.
+ */
+#include <string.h>
+
+#include "lathist.h"
+
+/* Index of the most significant set bit of v (v > 0) */
+static int msb(unsigned long long v)
+{
+    return 63 - __builtin_clzll(v);
+}
+
+/* bucket_index - Map a value to its bucket */
+static int bucket_index(unsigned long long v)
+{
+    int k, shift;
+
+    if (v < LH_SUB)
+	return (int)v;
+    k = msb(v);
+    shift = k - LH_SUB_BITS;
+    return LH_SUB * (shift + 1) + (int)((v >> shift) - LH_SUB);
+}
+
+/* bucket_top - Return the largest value that maps to bucket idx */
+static unsigned long long bucket_top(int idx)
+{
+    int shift;
+
+    if (idx < LH_SUB)
+	return (unsigned long long)idx;
+    shift = idx / LH_SUB - 1;
+    return (((unsigned long long)(idx % LH_SUB + LH_SUB) + 1) << shift) - 1;
+}
+
+/*
+ * lh_init - Reset a histogram to the empty state
+ */
+void lh_init(lathist_t *h)
+{
+    memset(h, 0, sizeof(lathist_t));
+}
+
+/*
+ * lh_record - Record a single value
+ */
+void lh_record(lathist_t *h, unsigned long long val)
+{
+    h->buckets[bucket_index(val)]++;
+    if (h->count == 0 || val < h->min)
+	h->min = val;
+    if (val > h->max)
+	h->max = val;
+    h->sum += (double)val;
+    h->count++;
+}
+
+/*
+ * lh_merge - Add all values recorded in src to dst
+ */
+void lh_merge(lathist_t *dst, lathist_t *src)
+{
+    int i;
+
+    if (src->count == 0)
+	return;
+    for (i = 0; i < LH_NBUCKETS; i++)
+	dst->buckets[i] += src->buckets[i];
+    if (dst->count == 0 || src->min < dst->min)
+	dst->min = src->min;
+    if (src->max > dst->max)
+	dst->max = src->max;
+    dst->sum += src->sum;
+    dst->count += src->count;
+}
+
+/*
+ * lh_percentile - Smallest bucket top covering pct percent of the values
+ */
+unsigned long long lh_percentile(lathist_t *h, double pct)
+{
+    unsigned long long target, seen = 0;
+    int i;
+
+    if (h->count == 0)
+	return 0;
+    target = (unsigned long long)(pct / 100.0 * h->count + 0.5);
+    if (target < 1)
+	target = 1;
+    if (target > h->count)
+	target = h->count;
+    for (i = 0; i < LH_NBUCKETS; i++) {
+	seen += h->buckets[i];
+	if (seen >= target)
+	    return (bucket_top(i) < h->max) ? bucket_top(i) : h->max;
+    }
+    return h->max;
+}
+
+/*
+ * lh_mean - Mean of the recorded values
+ */
+double lh_mean(lathist_t *h)
+{
+    return (h->count == 0) ? 0.0 : h->sum / h->count;
+}
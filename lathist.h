@@ -0,0 +1,39 @@
+/*
+ * lathist.h - log-linear (HDR-style) latency histograms
+ *
+ * Values (typically counter ticks) are recorded into buckets whose
+ * width doubles with every power of two, with LH_SUB linear sub-buckets
+ * per power of two. This bounds the relative error of any reported
+ * percentile to 1/LH_SUB while keeping the histogram a fixed size.
+ */
+
+#define LH_SUB_BITS 5                   /* log2 of sub-buckets per octave */
+#define LH_SUB (1 << LH_SUB_BITS)       /* => relative error < 3.2% */
+#define LH_NBUCKETS (LH_SUB * (64 - LH_SUB_BITS + 1))
+
+typedef struct {
+    unsigned long long count;           /* number of recorded values */
+    unsigned long long min;             /* smallest recorded value */
+    unsigned long long max;             /* largest recorded value */
+    double sum;                         /* sum of recorded values */
+    unsigned int buckets[LH_NBUCKETS];  /* per-bucket value counts */
+} lathist_t;
+
+/* Reset a histogram to the empty state */
+void lh_init(lathist_t *h);
+
+/* Record a single value */
+void lh_record(lathist_t *h, unsigned long long val);
+
+/* Add all values recorded in src to dst */
+void lh_merge(lathist_t *dst, lathist_t *src);
+
+/*
+ * lh_percentile - Return the smallest value v such that at least pct
+ *     percent (0..100) of the recorded values are <= v, rounded up to
+ *     the top of its bucket. Returns 0 for an empty histogram.
+ */
+unsigned long long lh_percentile(lathist_t *h, double pct);
+
+/* Mean of the recorded values */
+double lh_mean(lathist_t *h);
@@ -7,6 +7,7 @@
  * Copyright (c) 2002, R. Bryant and D. O'Hallaron, All rights reserved.
  * May not be used, modified, or copied without permission.
  */
+#define _GNU_SOURCE     /* for the CPU affinity calls in sched.h */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -15,10 +16,22 @@
 #include <assert.h>
 #include <float.h>
 #include <time.h>
+#include <math.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
 
 #include "mm.h"
 #include "memlib.h"
-#include "fsecs.h"
+#include "bench.h"
+#include "perfctr.h"
+#include "cacheinfo.h"
+#include "heapmap.h"
+#include "region.h"
+#include "clock.h"
+#include "lathist.h"
+#include "allocators.h"
 #include "config.h"
 
 /**********************
@@ -29,6 +42,19 @@
 #define MAXLINE     1024 /* max string size */
 #define HDRLINES       4 /* number of header lines in a trace file */
 #define LINENUM(i) (i+5) /* cnvt trace request nums to linenums (origin 1) */
+#define LAT_RUNS       5 /* replays of each trace when timing single ops */
+#define NUM_OPTYPES    3 /* number of distinct request types */
+#define MAXTHREADS    64 /* max number of threads in a trace */
+#define MAXREGIONS  1024 /* max number of regions in a trace */
+#define COLD_SAMPLES  30 /* max samples of each trace with cold caches (-C) */
+#define MAP_ROWS      64 /* default number of heap map rows per trace (-F) */
+#define SERIES_POINTS 256 /* default number of samples per trace (-u) */
+#define BATCH_MAX     64 /* max requests in one batch call (-B) */
+
+/* Upper bound on the number of CPUs that -j spreads its workers over */
+#ifndef CPU_SETSIZE
+#define CPU_SETSIZE 1    /* no CPU affinity support */
+#endif
 
 /* Returns true if p is ALIGNMENT-byte aligned */
 #define IS_ALIGNED(p)  ((((unsigned int)(p)) % ALIGNMENT) == 0)
@@ -49,6 +75,11 @@ typedef struct {
     enum {ALLOC, FREE, REALLOC} type; /* type of request */
     int index;                        /* index for free() to use later */
     int size;                         /* byte size of alloc/realloc request */
+    int tid;                          /* thread that issues the request */
+    int seq;                          /* number of earlier requests on index */
+    int region;                       /* region of an alloc, or destroyed by
+					 a free (-1: none) */
+    int hint;                         /* lifetime hint of an alloc (-L) */
 } traceop_t;
 
 /* Holds the information for one trace file*/
@@ -60,27 +91,91 @@ typedef struct {
     traceop_t *ops;      /* array of requests */
     char **blocks;       /* array of ptrs returned by malloc/realloc... */
     size_t *block_sizes; /* ... and a corresponding array of payload sizes */
+
+    /* used only by the multithreaded replay of traces with num_threads > 1 */
+    int num_threads;     /* number of threads (highest tid + 1) */
+    int *thread_nops;    /* number of requests issued by each thread... */
+    int **thread_ops;    /* ... and their indices in ops, in trace order */
+    int *done;           /* number of completed requests on each id */
+
+    /* used only by traces with region requests */
+    int num_regions;     /* number of regions (highest region id + 1) */
+    region_t **regions;  /* the live regions of a replay with the region API */
 } trace_t;
 
 /* 
- * Holds the params to the xxx_speed functions, which are timed by fcyc. 
- * This struct is necessary because fcyc accepts only a pointer array
- * as input.
+ * Holds the params to the xxx_speed functions, which are timed by
+ * bench_run. This struct is necessary because bench_run accepts only a
+ * pointer as input.
  */
 typedef struct {
     trace_t *trace;  
     range_t *ranges;
+    int from, to;        /* eval_mm_speed replays requests [from, to) */
+    char **blocks;       /* trace->blocks at request from, if from > 0 */
 } speed_t;
 
+/* Argument of each thread of the multithreaded replay engine */
+typedef struct {
+    trace_t *trace;      /* the trace being replayed */
+    allocator_t *pkg;    /* the package that serves the requests */
+    int locked;          /* serialize the calls into pkg with mt_lock? */
+    int tid;             /* the thread whose requests we issue */
+} mtthread_t;
+
+/* Called by replay_sampled after request op, with the live payload bytes */
+typedef void (*sampler_t)(trace_t *trace, int op, size_t live, void *arg);
+
+/* State of the heap map sampler of eval_mm_frag */
+typedef struct {
+    FILE *fp;            /* heap map output */
+    int pgm;             /* write PGM gray levels instead of text? */
+    int interval;        /* draw a row after every interval requests */
+    int peak;            /* request after which the payload peaks */
+    size_t maxheap;      /* final heap size, which sets the map's scale */
+    heapmap_t hm;        /* the sample just taken */
+    heapmap_t peak_hm;   /* the sample at the peak */
+} fragsampler_t;
+
+/* State of the footprint sampler of eval_mm_series */
+typedef struct {
+    FILE *fp;            /* time series output */
+    int json;            /* write JSON instead of CSV? */
+    int *first;          /* no JSON record written to fp yet? */
+    int interval;        /* write a sample after every interval requests */
+    int tracenum;        /* trace being replayed... */
+    char *file;          /* ... and its file name */
+    double util_sum;     /* sum over all requests of live/heap */
+    double live_sum;     /* sum over all requests of live */
+    size_t peak_heap;    /* largest heap size seen */
+    size_t peak_live;    /* largest live payload seen */
+} seriessampler_t;
+
 /* Summarizes the important stats for some malloc function on some trace */
 typedef struct {
     /* defined for both libc malloc and student malloc package (mm.c) */
     double ops;      /* number of ops (malloc/free/realloc) in the trace */
     int valid;       /* was the trace processed correctly by the allocator? */
-    double secs;     /* number of secs needed to run the trace */
+    double secs;     /* median number of secs needed to run the trace */
+    double secs_sd;  /* standard deviation of secs over the timed runs */
+    double secs_mad; /* median absolute deviation of secs */
+    double secs_lo;  /* 95% confidence interval of the median secs */
+    double secs_hi;
+    int runs;        /* number of timed runs that secs is the median of */
+    double faults;   /* page faults per timed run */
+    double events[PC_NEVENTS]; /* hardware event counts of one run (-e) */
+    double secs_cold; /* median secs with the caches evicted first (-C) */
+    double secs_region;/* median secs with the region API (0: no regions) */
+    double secs_free;/* ... and with per-object frees, both of the whole trace */
+    double ops_region;/* number of ops in the whole trace, even with -W */
 
     /* defined only for the student malloc package */
     double util;     /* space utilization for this trace (always 0 for libc) */
+    double util_avg; /* utilization averaged over all requests (-u) */
+    double live_avg; /* live payload averaged over all requests (-u) */
+    size_t peak_live;/* peak live payload (-u) */
+    int sbrks;       /* number of mem_sbrk calls while replaying the trace */
+    size_t heap;     /* final (and thus peak) heap size in bytes */
 
     /* Note: secs and util are only defined if valid is true */
 } stats_t; 
@@ -90,8 +185,27 @@ typedef struct {
  *******************/
 int verbose = 0;        /* global flag for verbose output */
 static int errors = 0;  /* number of errs found when running student malloc */
+static int check_every = 0; /* -c: mm_check after each request, in full every n */
+static int use_shadow = 0;  /* -w: validate with the shadow map, not the range list */
+static int use_hints = 0;   /* -L: pass lifetime hints to mm_malloc_hint */
+static int use_batch = 0;   /* -B: group runs of requests into batch calls */
+static int fresh_heap = 0;  /* -X: drop the heap's pages before each run */
+
+/* Shadow map of the simulated heap: the id+1 of the block that owns
+   each ALIGNMENT-byte granule, or 0 if no live payload touches it */
+static int *shadow = NULL;
+static size_t shadow_hwm = 0;  /* granules that may be nonzero */
 char msg[MAXLINE];      /* for whenever we need to compose an error message */
 
+/* The malloc package currently being evaluated (an entry of allocators) */
+static allocator_t *mm_pkg = allocators;
+
+/* The libc package, as seen by the multithreaded replay engine */
+static allocator_t libc_pkg = {"libc", NULL, NULL, malloc, free, realloc};
+
+/* Serializes the calls into packages that are not thread-safe, like mm.c */
+static pthread_mutex_t mt_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Directory where default tracefiles are found */
 static char tracedir[MAXLINE] = TRACEDIR;
 
@@ -100,6 +214,36 @@ static char *default_tracefiles[] = {
     DEFAULT_TRACEFILES, NULL
 };
 
+/* Request type names, indexed by traceop_t type */
+static char *optype_names[NUM_OPTYPES] = {"malloc", "free", "realloc"};
+
+/* Result of one correctness/utilization job, sent back by a worker (-j) */
+typedef struct {
+    int valid;       /* was the trace processed correctly? */
+    double util;     /* space utilization */
+    int sbrks;       /* number of mem_sbrk calls */
+    size_t heap;     /* final heap size */
+    int errors;      /* number of errors the worker reported */
+} jobresult_t;
+
+/* One record of a saved baseline, as written by -o and read by -b */
+typedef struct {
+    char alloc[MAXLINE]; /* allocator name ("mm" or "libc") */
+    char file[MAXLINE];  /* trace file name */
+    int valid;
+    double util;
+    double secs;
+    double secs_sd;
+    int runs;
+    double secs_lo;      /* 0 if the baseline predates the median CI */
+    double secs_hi;
+} baseline_t;
+
+/* Latency percentiles reported by -p and -P */
+#define NUM_PCTS 4
+static double lat_pcts[NUM_PCTS] = {50.0, 90.0, 99.0, 99.9};
+static char *lat_pct_names[NUM_PCTS] = {"p50", "p90", "p99", "p999"};
+
 
 /********************* 
  * Function prototypes 
@@ -111,8 +255,14 @@ static int add_range(range_t **ranges, char *lo, int size,
 static void remove_range(range_t **ranges, char *lo);
 static void clear_ranges(range_t **ranges);
 
+/* these functions manipulate the shadow map */
+static void shadow_reset(void);
+static int shadow_add(char *lo, int size, int id, int tracenum, int opnum);
+static int shadow_remove(char *lo, int size, int id, int tracenum, int opnum);
+
 /* These functions read, allocate, and free storage for traces */
 static trace_t *read_trace(char *tracedir, char *filename);
+static void set_hints(trace_t *trace);
 static void free_trace(trace_t *trace);
 
 /* Routines for evaluating the correctness and speed of libc malloc */
@@ -122,11 +272,68 @@ static void eval_libc_speed(void *ptr);
 /* Routines for evaluating correctnes, space utilization, and speed 
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
+static int check_usable(char *p, int size, int tracenum, int opnum);
+static void *alloc_op(traceop_t *op);
+static void *batch_alloc(trace_t *trace, int i, int end);
+static void batch_free(trace_t *trace, int i, int end, void *p);
 static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
 static void eval_mm_speed(void *ptr);
+static int warm_window(speed_t *params, int lo, int hi);
+static void restore_window(void *ptr);
+static void eval_mm_quality(trace_t *trace, int tracenum, range_t **ranges,
+			    stats_t *stats);
+static void eval_mm_latency(trace_t *trace, lathist_t *hists);
+static void replay_sampled(trace_t *trace, sampler_t sample, void *arg);
+static void eval_mm_frag(trace_t *trace, int tracenum, char *file, 
+			 size_t maxheap, int interval, char *mapfile);
+static void eval_mm_series(trace_t *trace, int tracenum, char *file, 
+			   int interval, FILE *fp, int *first, stats_t *stats);
+
+/* Replay of the region requests of a trace with the region API */
+static int eval_mm_region_valid(trace_t *trace, int tracenum);
+static void eval_mm_region_speed(void *ptr);
+
+/* Multithreaded replay of traces whose requests come from several threads */
+static void eval_mm_mtspeed(void *ptr);
+static void eval_libc_mtspeed(void *ptr);
+
+/* Parallel evaluation of correctness and utilization in worker processes */
+static void eval_parallel(int njobs, int npkgs, int n, char **tracefiles, 
+			  stats_t **pkg_stats);
+static void pin_to_cpu(int cpu);
+static void init_timer(void);
+static int list_cpus(int *cpus, int max);
+
+/* Repeated timing of the xxx_speed functions */
+static void measure_speed(bench_funct f, speed_t *params, 
+			  bench_params_t *bench, stats_t *stats);
+static void count_events(bench_funct f, speed_t *params, 
+			 stats_t *stats);
+static void measure_cold(bench_funct f, speed_t *params, 
+			 bench_params_t *bench, stats_t *stats);
+
+/* Export of the results and comparison against a saved baseline */
+static void writeresults(char *path, int n, char **tracefiles, 
+			 stats_t *libc_stats, stats_t **pkg_stats, int npkgs);
+static baseline_t *read_baseline(char *path, int *nrecs);
+static int compare_results(char *path, char *alloc, int n, 
+			   char **tracefiles, stats_t *stats);
 
 /* Various helper routines */
 static void printresults(int n, stats_t *stats);
+static void printmatrix(int n, stats_t *libc_stats, stats_t **pkg_stats, 
+			int npkgs);
+static void printlatency(int n, lathist_t *hists);
+static void printevents(int n, stats_t *stats);
+static void printcold(int n, stats_t *stats);
+static void printfaults(int n, stats_t *stats);
+static void printcaches(void);
+static void printmmstats(mm_stats_t *st);
+static void printfootprint(int n, stats_t *stats);
+static void printregions(int n, stats_t *stats);
+static void writelatency(char *path, int n, char **tracefiles, 
+			 lathist_t **pkg_lat, int npkgs);
+static int is_json(char *path);
 static void usage(void);
 static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
@@ -137,7 +344,7 @@ static void app_error(char *msg);
  **************/
 int main(int argc, char **argv)
 {
-    int i;
+    int i, j, k;
     char c;
     char **tracefiles = NULL;  /* null-terminated array of trace file names */
     int num_tracefiles = 0;    /* the number of traces in that array */
@@ -145,11 +352,38 @@ int main(int argc, char **argv)
     range_t *ranges = NULL;    /* keeps track of block extents for one trace */
     stats_t *libc_stats = NULL;/* libc stats for each trace */
     stats_t *mm_stats = NULL;  /* mm (i.e. student) stats for each trace */
+    stats_t **pkg_stats;       /* stats of each evaluated package (mm first) */
+    lathist_t **pkg_lat;       /* per-request latencies of each package */
+    int num_pkgs = 1;          /* number of packages to evaluate (-M: all) */
+    int njobs = 1;             /* number of worker processes (-j) */
+    int cpu;                   /* CPU that the timed runs are pinned to */
     speed_t speed_params;      /* input parameters to the xx_speed routines */ 
 
     int team_check = 1;  /* If set, check team structure (reset by -a) */
     int run_libc = 0;    /* If set, run libc malloc (set by -l) */
     int autograder = 0;  /* If set, emit summary info for autograder (-g) */
+    int latency = 0;     /* If set, time each request separately (-p, -P) */
+    char *latfile = NULL;/* If set, export latency percentiles here (-P) */
+    char *outfile = NULL;/* If set, export the results here (-o) */
+    char *basefile = NULL;/* If set, compare against this baseline (-b) */
+    bench_params_t bench;/* Sampling parameters of the timed runs (-n) */
+    int *order;          /* Order in which the traces are timed (-r) */
+    int seed = -1;       /* If >= 0, shuffle that order with this seed */
+    int regressions = 0; /* Number of regressions found by -b */
+    int counters = 0;    /* If set, count hardware events (-e) */
+    int cold = 0;        /* If set, also time with cold caches (-C) */
+    int mmstats = 0;     /* If set, dump the allocator's stats (-s) */
+    mm_stats_t st;       /* the allocator's stats after one replay */
+    char *mapfile = NULL;/* If set, write heap maps here (-F) */
+    int interval = 0;    /* Requests between samples (-i; 0: auto) */
+    char *seriesfile = NULL;/* If set, export the footprint series here (-u) */
+    FILE *seriesfp = NULL;
+    int seriesfirst = 1; /* no JSON record written to seriesfp yet? */
+    int regions = 0;     /* Did any trace time the region API? */
+    stats_t rst;         /* timing of a trace with the region API */
+    int win_lo = 0;      /* Time only this percentage range of each */
+    int win_hi = 100;    /* trace, after warming up the heap (-W) */
+    int mem_flags = 0;   /* How to back the simulated heap (-z, -H) */
 
     /* temporaries used to compute the performance index */
     double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
@@ -158,7 +392,10 @@ int main(int argc, char **argv)
     /* 
      * Read and interpret the command line arguments 
      */
-    while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF) {
+    bench_init(&bench);
+    speed_params.from = 0;
+    speed_params.blocks = NULL;
+    while ((c = getopt(argc, argv, "f:t:hvVgalpeCsP:o:b:n:r:Mj:F:i:u:c:wLBW:XzH")) != EOF) {
         switch (c) {
 	case 'g': /* Generate summary info for the autograder */
 	    autograder = 1;
@@ -184,6 +421,87 @@ int main(int argc, char **argv)
         case 'l': /* Run libc malloc */
             run_libc = 1;
             break;
+        case 'j': /* Check correctness and utilization in parallel */
+            njobs = atoi(optarg);
+            if (njobs < 1)
+		app_error("The number of workers (-j) must be at least 1");
+            break;
+        case 'M': /* Run every registered malloc package */
+            for (num_pkgs = 0; allocators[num_pkgs].name; num_pkgs++)
+		;
+            break;
+        case 'p': /* Print per-request latency percentiles */
+            latency = 1;
+            break;
+        case 's': /* Dump the allocator's internal stats after each trace */
+            mmstats = 1;
+            break;
+        case 'F': /* Analyze fragmentation and write heap maps */
+            mapfile = strdup(optarg);
+            break;
+        case 'i': /* Requests between heap map rows and footprint samples */
+            interval = atoi(optarg);
+            if (interval < 1)
+		app_error("The sampling interval (-i) must be at least 1");
+            break;
+        case 'c': /* Check the heap while validating */
+            check_every = atoi(optarg);
+            if (check_every < 1)
+		app_error("The full check interval (-c) must be at least 1");
+            break;
+        case 'w': /* Validate with the shadow map */
+            use_shadow = 1;
+            break;
+        case 'L': /* Pass the lifetime of each block as a hint */
+            use_hints = 1;
+            break;
+        case 'B': /* Replay runs of allocs and frees with batch calls */
+            use_batch = 1;
+            break;
+        case 'W': /* Time only a steady-state window of each trace */
+            if (sscanf(optarg, "%d:%d", &win_lo, &win_hi) < 1 ||
+		win_lo < 0 || win_hi > 100 || win_lo >= win_hi)
+		app_error("The window (-W) must be <lo>[:<hi>] with 0 <= lo < hi <= 100");
+            break;
+        case 'X': /* Time each run in a process of its own */
+            bench.isolate = 1;
+            fresh_heap = 1;
+            break;
+        case 'z': /* Fault in the whole simulated heap up front */
+            mem_flags |= MEM_PREFAULT;
+            break;
+        case 'H': /* Back the simulated heap with huge pages */
+            mem_flags |= MEM_HUGEPAGES;
+            break;
+        case 'u': /* Export the footprint over time */
+            seriesfile = strdup(optarg);
+            break;
+        case 'C': /* Time with cold caches as well */
+            cold = 1;
+            break;
+        case 'e': /* Count hardware events */
+            counters = 1;
+            break;
+        case 'P': /* Export per-request latency percentiles to a file */
+            latency = 1;
+            latfile = strdup(optarg);
+            break;
+        case 'o': /* Export the results to a file */
+            outfile = strdup(optarg);
+            break;
+        case 'b': /* Compare the results against a saved baseline */
+            basefile = strdup(optarg);
+            break;
+        case 'n': /* Minimum number of timed runs per trace */
+            bench.min_samples = atoi(optarg);
+            if (bench.min_samples < 1)
+		app_error("The number of runs (-n) must be at least 1");
+            if (bench.max_samples < bench.min_samples)
+		bench.max_samples = bench.min_samples;
+            break;
+        case 'r': /* Time the traces in a random order */
+            seed = atoi(optarg);
+            break;
         case 'v': /* Print per-trace performance breakdown */
             verbose = 1;
             break;
@@ -235,8 +553,76 @@ int main(int argc, char **argv)
 	printf("Using default tracefiles in %s\n", tracedir);
     }
 
-    /* Initialize the timing package */
-    init_fsecs();
+    /* 
+     * Time the traces in a random order with -r, so that a slow trace
+     * doesn't always follow the same one and the heap layout and clock
+     * speed left behind by one trace don't always bias the next one
+     */
+    if ((order = (int *)malloc(num_tracefiles * sizeof(int))) == NULL)
+	unix_error("order malloc in main failed");
+    for (i=0; i < num_tracefiles; i++)
+	order[i] = i;
+    if (seed >= 0) {
+	srand(seed);
+	for (i=num_tracefiles-1; i > 0; i--) {
+	    j = rand() % (i + 1);
+	    k = order[i];
+	    order[i] = order[j];
+	    order[j] = k;
+	}
+    }
+
+    /* Allocate the mm stats arrays, with one stats_t struct per tracefile */
+    pkg_stats = (stats_t **)calloc(num_pkgs, sizeof(stats_t *));
+    pkg_lat = (lathist_t **)calloc(num_pkgs, sizeof(lathist_t *));
+    if (pkg_stats == NULL || pkg_lat == NULL)
+	unix_error("pkg_stats calloc in main failed");
+    for (k=0; k < num_pkgs; k++) {
+	pkg_stats[k] = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
+	if (pkg_stats[k] == NULL)
+	    unix_error("mm_stats calloc in main failed");
+    }
+    
+    /* Open the footprint time series */
+    if (seriesfile) {
+	if ((seriesfp = fopen(seriesfile, "w")) == NULL) {
+	    sprintf(msg, "Could not open %s in main", seriesfile);
+	    unix_error(msg);
+	}
+	if (is_json(seriesfile))
+	    fprintf(seriesfp, "[\n");
+	else
+	    fprintf(seriesfp, "allocator,trace,file,op,live,heap,free\n");
+    }
+
+    /* Initialize the simulated memory system in memlib.c */
+    mem_init_flags(mem_flags); 
+
+    /*
+     * With -j, check the correctness and utilization of every package
+     * on every trace up front in a pool of worker processes. The timed
+     * runs below then happen one at a time, on a CPU of their own.
+     */
+    if (njobs > 1)
+	eval_parallel(njobs, num_pkgs, num_tracefiles, tracefiles, pkg_stats);
+
+    /* 
+     * Calibrate the counter on a single CPU (eval_parallel has already
+     * pinned us), so it never migrates between cores in the middle of a
+     * measurement.
+     */
+    if (njobs == 1 && list_cpus(&cpu, 1) == 1 && cpu >= 0)
+	pin_to_cpu(cpu);
+    init_timer();
+
+    if (cold && verbose > 1)
+	printcaches();
+
+    /* Open the hardware counters, if there are any */
+    if (counters && pc_open(verbose > 1) == 0) {
+	printf("No hardware counters available, ignoring -e\n");
+	counters = 0;
+    }
 
     /*
      * Optionally run and evaluate the libc malloc package 
@@ -250,8 +636,9 @@ int main(int argc, char **argv)
 	if (libc_stats == NULL)
 	    unix_error("libc_stats calloc in main failed");
 	
-	/* Evaluate the libc malloc package using the K-best scheme */
-	for (i=0; i < num_tracefiles; i++) {
+	/* Evaluate the libc malloc package, timing it with bench_run */
+	for (j=0; j < num_tracefiles; j++) {
+	    i = order[j];
 	    trace = read_trace(tracedir, tracefiles[i]);
 	    libc_stats[i].ops = trace->num_ops;
 	    if (verbose > 1)
@@ -261,7 +648,17 @@ int main(int argc, char **argv)
 		speed_params.trace = trace;
 		if (verbose > 1)
 		    printf("and performance.\n");
-		libc_stats[i].secs = fsecs(eval_libc_speed, &speed_params);
+		measure_speed(trace->num_threads > 1 ? eval_libc_mtspeed : 
+			      eval_libc_speed, &speed_params, &bench, 
+			      &libc_stats[i]);
+		if (counters)
+		    count_events(trace->num_threads > 1 ? eval_libc_mtspeed :
+				 eval_libc_speed, &speed_params, 
+				 &libc_stats[i]);
+		if (cold)
+		    measure_cold(trace->num_threads > 1 ? eval_libc_mtspeed :
+				 eval_libc_speed, &speed_params, &bench,
+				 &libc_stats[i]);
 	    }
 	    free_trace(trace);
 	}
@@ -270,49 +667,176 @@ int main(int argc, char **argv)
 	if (verbose) {
 	    printf("\nResults for libc malloc:\n");
 	    printresults(num_tracefiles, libc_stats);
+	    printf("\nPage faults per timed run for libc malloc:\n");
+	    printfaults(num_tracefiles, libc_stats);
+	}
+	if (cold) {
+	    printf("\nWarm and cold cache throughput for libc malloc:\n");
+	    printcold(num_tracefiles, libc_stats);
+	}
+	if (counters) {
+	    printf("\nHardware events per request for libc malloc:\n");
+	    printevents(num_tracefiles, libc_stats);
+	    printf("\n");
 	}
     }
 
     /*
-     * Always run and evaluate the student's mm package
+     * Always run and evaluate the student's mm package, and with -M
+     * every other registered package as well
      */
-    if (verbose > 1)
-	printf("\nTesting mm malloc\n");
+    for (k=0; k < num_pkgs; k++) {
+	mm_pkg = &allocators[k];
+	mm_stats = pkg_stats[k];
+	if (verbose > 1)
+	    printf("\nTesting %s malloc\n", mm_pkg->name);
+	if ((win_lo > 0 || win_hi < 100) && mm_pkg->snapshot == NULL)
+	    printf("%s malloc can't take snapshots, ignoring -W\n", 
+		   mm_pkg->name);
+
+	/* Allocate the latency histograms, NUM_OPTYPES per tracefile */
+	if (latency) {
+	    pkg_lat[k] = (lathist_t *)calloc(num_tracefiles * NUM_OPTYPES, 
+					     sizeof(lathist_t));
+	    if (pkg_lat[k] == NULL)
+		unix_error("pkg_lat calloc in main failed");
+	}
 
-    /* Allocate the mm stats array, with one stats_t struct per tracefile */
-    mm_stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
-    if (mm_stats == NULL)
-	unix_error("mm_stats calloc in main failed");
-    
-    /* Initialize the simulated memory system in memlib.c */
-    mem_init(); 
+	/* Evaluate the malloc package, timing it with bench_run */
+	for (j=0; j < num_tracefiles; j++) {
+	    i = order[j];
+	    trace = read_trace(tracedir, tracefiles[i]);
+	    mm_stats[i].ops = trace->num_ops;
+	    if (njobs == 1)
+		eval_mm_quality(trace, i, &ranges, &mm_stats[i]);
+	    if (mm_stats[i].valid) {
+		speed_params.trace = trace;
+		speed_params.ranges = ranges;
+		speed_params.from = 0;
+		speed_params.to = trace->num_ops;
+		if (trace->num_threads == 1 && 
+		    warm_window(&speed_params, win_lo, win_hi))
+		    mm_stats[i].ops = speed_params.to - speed_params.from;
+		if (verbose > 1)
+		    printf("Measuring %s malloc performance.\n", mm_pkg->name);
+		measure_speed(trace->num_threads > 1 ? eval_mm_mtspeed : 
+			      eval_mm_speed, &speed_params, &bench, 
+			      &mm_stats[i]);
+		if (counters)
+		    count_events(trace->num_threads > 1 ? eval_mm_mtspeed : 
+				 eval_mm_speed, &speed_params, &mm_stats[i]);
+		if (cold)
+		    measure_cold(trace->num_threads > 1 ? eval_mm_mtspeed : 
+				 eval_mm_speed, &speed_params, &bench, 
+				 &mm_stats[i]);
+		speed_params.from = 0;
+		speed_params.to = trace->num_ops;
+		if (trace->num_regions > 0 && mm_pkg == allocators &&
+		    eval_mm_region_valid(trace, i)) {
+		    if (verbose > 1)
+			printf("Measuring the region API.\n");
+		    memset(&rst, 0, sizeof(rst));
+		    measure_speed(eval_mm_region_speed, &speed_params, &bench,
+				  &rst);
+		    mm_stats[i].secs_region = rst.secs;
+		    mm_stats[i].secs_free = mm_stats[i].secs;
+		    mm_stats[i].ops_region = trace->num_ops;
+
+		    /* With -W, time the whole trace with per-object frees too */
+		    if (mm_stats[i].ops != trace->num_ops) {
+			memset(&rst, 0, sizeof(rst));
+			measure_speed(eval_mm_speed, &speed_params, &bench,
+				      &rst);
+			mm_stats[i].secs_free = rst.secs;
+		    }
+		    regions = 1;
+		}
+		if (seriesfp)
+		    eval_mm_series(trace, i, tracefiles[i], interval, seriesfp,
+				   is_json(seriesfile) ? &seriesfirst : NULL,
+				   &mm_stats[i]);
+		if (mapfile && mm_pkg->walk)
+		    eval_mm_frag(trace, i, tracefiles[i], mm_stats[i].heap,
+				 interval, mapfile);
+		if (mmstats && mm_pkg->stats) {
+		    speed_params.trace = trace;
+		    eval_mm_speed(&speed_params);
+		    mm_pkg->stats(&st);
+		    printf("%s malloc stats after trace %d (%s):\n", 
+			   mm_pkg->name, i, tracefiles[i]);
+		    printmmstats(&st);
+		}
+		if (latency) {
+		    if (verbose > 1)
+			printf("Timing individual %s requests.\n", mm_pkg->name);
+		    eval_mm_latency(trace, &pkg_lat[k][i * NUM_OPTYPES]);
+		}
+	    }
+	    free_trace(trace);
+	}
 
-    /* Evaluate student's mm malloc package using the K-best scheme */
-    for (i=0; i < num_tracefiles; i++) {
-	trace = read_trace(tracedir, tracefiles[i]);
-	mm_stats[i].ops = trace->num_ops;
-	if (verbose > 1)
-	    printf("Checking mm_malloc for correctness, ");
-	mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
-	if (mm_stats[i].valid) {
-	    if (verbose > 1)
-		printf("efficiency, ");
-	    mm_stats[i].util = eval_mm_util(trace, i, &ranges);
-	    speed_params.trace = trace;
-	    speed_params.ranges = ranges;
-	    if (verbose > 1)
-		printf("and performance.\n");
-	    mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
+	/* Display the results in a compact table */
+	if (verbose) {
+	    printf("\nResults for %s malloc:\n", mm_pkg->name);
+	    printresults(num_tracefiles, mm_stats);
+	    printf("\n");
+	    printf("Page faults per timed run for %s malloc:\n", mm_pkg->name);
+	    printfaults(num_tracefiles, mm_stats);
+	    printf("\n");
+	}
+
+	/* Display the footprint summary */
+	if (seriesfp) {
+	    printf("Footprint over time for %s malloc:\n", mm_pkg->name);
+	    printfootprint(num_tracefiles, mm_stats);
+	    printf("\n");
+	}
+
+	/* Display the region API against per-object frees */
+	if (regions && mm_pkg == allocators) {
+	    printf("Region API vs per-object frees for %s malloc:\n", 
+		   mm_pkg->name);
+	    printregions(num_tracefiles, mm_stats);
+	    printf("\n");
+	}
+
+	/* Display the warm and cold cache results side by side */
+	if (cold) {
+	    printf("Warm and cold cache throughput for %s malloc:\n", 
+		   mm_pkg->name);
+	    printcold(num_tracefiles, mm_stats);
+	    printf("\n");
+	}
+
+	/* Display the hardware event counts */
+	if (counters) {
+	    printf("Hardware events per request for %s malloc:\n", 
+		   mm_pkg->name);
+	    printevents(num_tracefiles, mm_stats);
+	    printf("\n");
+	}
+
+	/* Display the per-request latency percentiles */
+	if (latency) {
+	    printf("Latency percentiles for %s malloc (ns):\n", mm_pkg->name);
+	    printlatency(num_tracefiles, pkg_lat[k]);
+	    printf("\n");
 	}
-	free_trace(trace);
+    }
+    if (latfile)
+	writelatency(latfile, num_tracefiles, tracefiles, pkg_lat, num_pkgs);
+    if (seriesfp) {
+	if (is_json(seriesfile))
+	    fprintf(seriesfp, "\n]\n");
+	fclose(seriesfp);
     }
 
-    /* Display the mm results in a compact table */
-    if (verbose) {
-	printf("\nResults for mm malloc:\n");
-	printresults(num_tracefiles, mm_stats);
+    /* Compare the packages side by side */
+    if (num_pkgs > 1) {
+	printmatrix(num_tracefiles, libc_stats, pkg_stats, num_pkgs);
 	printf("\n");
     }
+    mm_stats = pkg_stats[0];
 
     /* 
      * Accumulate the aggregate statistics for the student's mm package 
@@ -362,6 +886,28 @@ int main(int argc, char **argv)
 	printf("perfidx:%.0f\n", perfindex);
     }
 
+    /* The counters stay open until printevents has seen which exist */
+    if (counters)
+	pc_close();
+
+    /* Export the results and compare them against a saved baseline */
+    if (outfile)
+	writeresults(outfile, num_tracefiles, tracefiles, 
+		     libc_stats, pkg_stats, num_pkgs);
+    if (basefile) {
+	if (run_libc)
+	    regressions += compare_results(basefile, "libc", num_tracefiles,
+					   tracefiles, libc_stats);
+	for (k=0; k < num_pkgs; k++)
+	    regressions += compare_results(basefile, allocators[k].name, 
+					   num_tracefiles, tracefiles, 
+					   pkg_stats[k]);
+	if (regressions) {
+	    printf("Found %d regressions against %s\n", regressions, basefile);
+	    exit(2);
+	}
+    }
+
     exit(0);
 }
 
@@ -464,6 +1010,97 @@ static void clear_ranges(range_t **ranges)
 }
 
 
+/*****************************************************************
+ * The following routines maintain the shadow map (-w), which records
+ * the owner of every ALIGNMENT-byte granule of the heap. Since all
+ * payloads start on a granule boundary, two payloads overlap if and 
+ * only if they share a granule, so each check is O(size) with no 
+ * searching, however many blocks are live.
+ ****************************************************************/
+
+/*
+ * shadow_reset - Mark the whole heap as unowned
+ */
+static void shadow_reset(void)
+{
+    if (shadow == NULL && 
+	(shadow = (int *)calloc(MAX_HEAP / ALIGNMENT, sizeof(int))) == NULL)
+	unix_error("calloc failed in shadow_reset");
+    memset(shadow, 0, shadow_hwm * sizeof(int));
+    shadow_hwm = 0;
+}
+
+/*
+ * shadow_add - As directed by request opnum in trace tracenum, the 
+ *     student's malloc or realloc returned the size byte payload lo 
+ *     for block id. Check it like add_range, and mark its granules.
+ */
+static int shadow_add(char *lo, int size, int id, int tracenum, int opnum)
+{
+    char *hi = lo + size - 1;
+    char *heap_lo = (char *)mem_heap_lo();
+    size_t g, first, last;
+
+    assert(size > 0);
+
+    /* Payload addresses must be ALIGNMENT-byte aligned */
+    if (!IS_ALIGNED(lo)) {
+	sprintf(msg, "Payload address (%p) not aligned to %d bytes", 
+		lo, ALIGNMENT);
+        malloc_error(tracenum, opnum, msg);
+        return 0;
+    }
+
+    /* The payload must lie within the extent of the heap */
+    if ((lo < heap_lo) || (hi > (char *)mem_heap_hi())) {
+	sprintf(msg, "Payload (%p:%p) lies outside heap (%p:%p)",
+		lo, hi, mem_heap_lo(), mem_heap_hi());
+	malloc_error(tracenum, opnum, msg);
+        return 0;
+    }
+
+    /* The payload must not share a granule with any other payload */
+    first = (lo - heap_lo) / ALIGNMENT;
+    last = (hi - heap_lo) / ALIGNMENT;
+    for (g = first; g <= last; g++) {
+	if (shadow[g]) {
+	    sprintf(msg, "Payload (%p:%p) of block %d overlaps block %d at %p",
+		    lo, hi, id, shadow[g] - 1, heap_lo + g * ALIGNMENT);
+	    malloc_error(tracenum, opnum, msg);
+	    return 0;
+	}
+	shadow[g] = id + 1;
+    }
+    if (last + 1 > shadow_hwm)
+	shadow_hwm = last + 1;
+    return 1;
+}
+
+/*
+ * shadow_remove - Before request opnum frees or reallocates block id,
+ *     check that its payload still holds the byte pattern the driver 
+ *     wrote into it (the allocator must not write into live blocks), 
+ *     and mark its granules unowned
+ */
+static int shadow_remove(char *lo, int size, int id, int tracenum, int opnum)
+{
+    size_t g, first = (lo - (char *)mem_heap_lo()) / ALIGNMENT;
+    int i;
+
+    for (i = 0; i < size; i++) {
+	if (lo[i] != (char)(id & 0xFF)) {
+	    sprintf(msg, "Payload of block %d was overwritten at %p while "
+		    "it was allocated", id, lo + i);
+	    malloc_error(tracenum, opnum, msg);
+	    return 0;
+	}
+    }
+    for (g = first; g < first + (size + ALIGNMENT - 1) / ALIGNMENT; g++)
+	shadow[g] = 0;
+    return 1;
+}
+
+
 /**********************************************
  * The following routines manipulate tracefiles
  *********************************************/
@@ -477,9 +1114,11 @@ static trace_t *read_trace(char *tracedir, char *filename)
     trace_t *trace;
     char type[MAXLINE];
     char path[MAXLINE];
-    unsigned index, size;
+    unsigned index, size, region;
     unsigned max_index = 0;
-    unsigned op_index;
+    unsigned op_index, nlines;
+    char *tag;
+    int tid, i, *owner, *nseen, *inregion, *rnext, rhead[MAXREGIONS];
 
     if (verbose > 1)
 	printf("Reading tracefile: %s\n", filename);
@@ -500,9 +1139,11 @@ static trace_t *read_trace(char *tracedir, char *filename)
     fscanf(tracefile, "%d", &(trace->num_ops));     
     fscanf(tracefile, "%d", &(trace->weight));        /* not used */
     
-    /* We'll store each request line in the trace in this array */
-    if ((trace->ops = 
-	 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
+    /* We'll store each request line in the trace in this array. A region
+       destroy becomes one free per block of the region, so there are at 
+       most num_ops + num_ids requests. */
+    if ((trace->ops = (traceop_t *)malloc((trace->num_ops + trace->num_ids)
+					  * sizeof(traceop_t))) == NULL)
 	unix_error("malloc 2 failed in read_trace");
 
     /* We'll keep an array of pointers to the allocated blocks here... */
@@ -514,11 +1155,51 @@ static trace_t *read_trace(char *tracedir, char *filename)
     if ((trace->block_sizes = 
 	 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
 	unix_error("malloc 4 failed in read_trace");
+
+    /* The thread that allocated each id, and the number of requests on it */
+    if ((owner = (int *)calloc(trace->num_ids, sizeof(int))) == NULL ||
+	(nseen = (int *)calloc(trace->num_ids, sizeof(int))) == NULL)
+	unix_error("calloc failed in read_trace");
+
+    /* The region+1 of each id (0: none), and the blocks of each region */
+    if ((inregion = (int *)calloc(trace->num_ids, sizeof(int))) == NULL ||
+	(rnext = (int *)malloc(trace->num_ids * sizeof(int))) == NULL)
+	unix_error("calloc failed in read_trace");
+    for (i = 0; i < MAXREGIONS; i++)
+	rhead[i] = -1;
+    trace->num_regions = 0;
+    trace->regions = NULL;
     
     /* read every request line in the trace file */
     index = 0;
     op_index = 0;
+    nlines = 0;
+    trace->num_threads = 1;
     while (fscanf(tracefile, "%s", type) != EOF) {
+	nlines++;
+	if (op_index == trace->num_ops + trace->num_ids) {
+	    printf("More requests than the header says in tracefile %s\n", 
+		   path);
+	    exit(1);
+	}
+	/* An optional "@<tid>" suffix names the thread that issues it */
+	tid = 0;
+	if ((tag = strchr(type, '@')) != NULL)
+	    tid = atoi(tag + 1);
+	if (tid < 0 || tid >= MAXTHREADS) {
+	    printf("Bad thread id (%s) in tracefile %s\n", type, path);
+	    exit(1);
+	}
+	if (tid >= trace->num_threads)
+	    trace->num_threads = tid + 1;
+	trace->ops[op_index].tid = tid;
+	trace->ops[op_index].region = -1;
+	if ((type[0] == 'g' || type[0] == 'd') && tid != 0) {
+	    printf("Region request (%s) by a thread other than 0 in "
+		   "tracefile %s\n", type, path);
+	    exit(1);
+	}
+
 	switch(type[0]) {
 	case 'a':
 	    fscanf(tracefile, "%u %u", &index, &size);
@@ -526,6 +1207,8 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	    trace->ops[op_index].index = index;
 	    trace->ops[op_index].size = size;
 	    max_index = (index > max_index) ? index : max_index;
+	    if (index < trace->num_ids)
+		owner[index] = tid;
 	    break;
 	case 'r':
 	    fscanf(tracefile, "%u %u", &index, &size);
@@ -539,30 +1222,176 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	    trace->ops[op_index].type = FREE;
 	    trace->ops[op_index].index = index;
 	    break;
+	case 'g': /* allocation in a region */
+	    fscanf(tracefile, "%u %u %u", &region, &index, &size);
+	    if (region >= MAXREGIONS) {
+		printf("Region id %u out of range in tracefile %s\n", 
+		       region, path);
+		exit(1);
+	    }
+	    trace->ops[op_index].type = ALLOC;
+	    trace->ops[op_index].index = index;
+	    trace->ops[op_index].size = size;
+	    trace->ops[op_index].region = region;
+	    max_index = (index > max_index) ? index : max_index;
+	    if (region >= trace->num_regions)
+		trace->num_regions = region + 1;
+	    break;
+	case 'd': /* region destroy: a free of every block in the region */
+	    fscanf(tracefile, "%u", &region);
+	    if (region >= MAXREGIONS) {
+		printf("Region id %u out of range in tracefile %s\n", 
+		       region, path);
+		exit(1);
+	    }
+	    for (i = rhead[region]; i >= 0; i = rnext[i]) {
+		if (op_index == trace->num_ops + trace->num_ids) {
+		    printf("More requests than the header says in "
+			   "tracefile %s\n", path);
+		    exit(1);
+		}
+		trace->ops[op_index].type = FREE;
+		trace->ops[op_index].index = i;
+		trace->ops[op_index].tid = 0;
+		trace->ops[op_index].region = region;
+		trace->ops[op_index].seq = nseen[i]++;
+		inregion[i] = 0;
+		op_index++;
+	    }
+	    rhead[region] = -1;
+	    continue;
+	case 'x': /* remote free: by a thread other than the allocating one */
+	    fscanf(tracefile, "%ud", &index);
+	    trace->ops[op_index].type = FREE;
+	    trace->ops[op_index].index = index;
+	    if (index < trace->num_ids && owner[index] == tid) {
+		printf("Remote free (%s %u) by the allocating thread in "
+		       "tracefile %s\n", type, index, path);
+		exit(1);
+	    }
+	    break;
 	default:
 	    printf("Bogus type character (%c) in tracefile %s\n", 
 		   type[0], path);
 	    exit(1);
 	}
+	if (trace->ops[op_index].index >= trace->num_ids) {
+	    printf("Request id %d out of range in tracefile %s\n", 
+		   trace->ops[op_index].index, path);
+	    exit(1);
+	}
+	if ((type[0] == 'a' || type[0] == 'g') && 
+	    (nseen[index] || inregion[index])) {
+	    printf("Reused ID %u (%s %u) in tracefile %s\n", index, type, 
+		   index, path);
+	    exit(1);
+	}
+	if (type[0] != 'g' && inregion[trace->ops[op_index].index]) {
+	    printf("Request (%s %d) on a block of a region in tracefile %s\n",
+		   type, trace->ops[op_index].index, path);
+	    exit(1);
+	}
+	trace->ops[op_index].seq = nseen[trace->ops[op_index].index]++;
+
+	/* Link a block allocated in a region into the region's list */
+	if (type[0] == 'g') {
+	    inregion[index] = region + 1;
+	    rnext[index] = rhead[region];
+	    rhead[region] = index;
+	}
 	op_index++;
 	
     }
     fclose(tracefile);
     assert(max_index == trace->num_ids - 1);
-    assert(trace->num_ops == op_index);
+    assert(trace->num_ops == nlines);
+    trace->num_ops = op_index;
+    set_hints(trace);
+    free(owner);
+    free(nseen);
+    free(inregion);
+    free(rnext);
+    if (trace->num_regions > 0 &&
+	(trace->regions = (region_t **)calloc(trace->num_regions, 
+					      sizeof(region_t *))) == NULL)
+	unix_error("calloc failed in read_trace");
+
+    /* Split the requests of multithreaded traces into per-thread lists */
+    trace->thread_nops = NULL;
+    trace->thread_ops = NULL;
+    trace->done = NULL;
+    if (trace->num_threads > 1) {
+	if ((trace->thread_nops = 
+	     (int *)calloc(trace->num_threads, sizeof(int))) == NULL ||
+	    (trace->thread_ops = 
+	     (int **)calloc(trace->num_threads, sizeof(int *))) == NULL ||
+	    (trace->done = (int *)calloc(trace->num_ids, sizeof(int))) == NULL)
+	    unix_error("calloc failed in read_trace");
+	for (i = 0; i < trace->num_ops; i++)
+	    trace->thread_nops[trace->ops[i].tid]++;
+	for (tid = 0; tid < trace->num_threads; tid++)
+	    if ((trace->thread_ops[tid] = 
+		 (int *)malloc((trace->thread_nops[tid] + 1) * sizeof(int))) 
+		== NULL)
+		unix_error("malloc failed in read_trace");
+	memset(trace->thread_nops, 0, trace->num_threads * sizeof(int));
+	for (i = 0; i < trace->num_ops; i++) {
+	    tid = trace->ops[i].tid;
+	    trace->thread_ops[tid][trace->thread_nops[tid]++] = i;
+	}
+    }
     
     return trace;
 }
 
+/*
+ * set_hints - Give each alloc the lifetime hint that -L passes: a block
+ *     is long-lived if it outlives half of the trace's requests, or is
+ *     never freed. A realloc ends the lifetime of the block it moves.
+ */
+static void set_hints(trace_t *trace)
+{
+    int i, *born;
+    traceop_t *op;
+
+    if ((born = (int *)malloc(trace->num_ids * sizeof(int))) == NULL)
+	unix_error("malloc failed in set_hints");
+    for (i = 0; i < trace->num_ids; i++)
+	born[i] = -1;
+    for (i = 0; i < trace->num_ops; i++) {
+	op = &trace->ops[i];
+	op->hint = MM_HINT_NONE;
+	if (op->type != ALLOC && born[op->index] >= 0)
+	    trace->ops[born[op->index]].hint = 
+		(i - born[op->index] >= trace->num_ops / 2) ? 
+		MM_HINT_LONG : MM_HINT_SHORT;
+	born[op->index] = (op->type == ALLOC) ? i : -1;
+    }
+    for (i = 0; i < trace->num_ids; i++)
+	if (born[i] >= 0)
+	    trace->ops[born[i]].hint = MM_HINT_LONG;
+    free(born);
+}
+
 /*
  * free_trace - Free the trace record and the three arrays it points
  *              to, all of which were allocated in read_trace().
  */
 void free_trace(trace_t *trace)
 {
+    int tid;
+
     free(trace->ops);         /* free the three arrays... */
     free(trace->blocks);      
     free(trace->block_sizes);
+    if (trace->num_threads > 1) { /* ... the per-thread request lists ... */
+	for (tid = 0; tid < trace->num_threads; tid++)
+	    free(trace->thread_ops[tid]);
+	free(trace->thread_ops);
+	free(trace->thread_nops);
+	free(trace->done);
+    }
+    free(trace->regions);
     free(trace);              /* and the trace record itself... */
 }
 
@@ -576,7 +1405,7 @@ void free_trace(trace_t *trace)
  */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges) 
 {
-    int i, j;
+    int i, j, full;
     int index;
     int size;
     int oldsize;
@@ -587,9 +1416,11 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
     /* Reset the heap and free any records in the range list */
     mem_reset_brk();
     clear_ranges(ranges);
+    if (use_shadow)
+	shadow_reset();
 
     /* Call the mm package's init function */
-    if (mm_init() < 0) {
+    if (mm_pkg->init() < 0) {
 	malloc_error(tracenum, 0, "mm_init failed.");
 	return 0;
     }
@@ -604,7 +1435,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
         case ALLOC: /* mm_malloc */
 
 	    /* Call the student's malloc */
-	    if ((p = mm_malloc(size)) == NULL) {
+	    if ((p = batch_alloc(trace, i, trace->num_ops)) == NULL) {
 		malloc_error(tracenum, i, "mm_malloc failed.");
 		return 0;
 	    }
@@ -614,7 +1445,8 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	     * to the range list if OK. The block must be  be aligned properly,
 	     * and must not overlap any currently allocated block. 
 	     */ 
-	    if (add_range(ranges, p, size, tracenum, i) == 0)
+	    if (use_shadow ? shadow_add(p, size, index, tracenum, i) == 0 :
+		add_range(ranges, p, size, tracenum, i) == 0)
 		return 0;
 	    
 	    /* ADDED: cgw
@@ -623,6 +1455,8 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	     * data was copied to the new block
 	     */
 	    memset(p, index & 0xFF, size);
+	    if (check_usable(p, size, tracenum, i) == 0)
+		return 0;
 
 	    /* Remember region */
 	    trace->blocks[index] = p;
@@ -633,16 +1467,21 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    
 	    /* Call the student's realloc */
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp, size)) == NULL) {
+	    if (use_shadow && shadow_remove(oldp, trace->block_sizes[index],
+					    index, tracenum, i) == 0)
+		return 0;
+	    if ((newp = mm_pkg->realloc(oldp, size)) == NULL) {
 		malloc_error(tracenum, i, "mm_realloc failed.");
 		return 0;
 	    }
 	    
 	    /* Remove the old region from the range list */
-	    remove_range(ranges, oldp);
+	    if (!use_shadow)
+		remove_range(ranges, oldp);
 	    
 	    /* Check new block for correctness and add it to range list */
-	    if (add_range(ranges, newp, size, tracenum, i) == 0)
+	    if (use_shadow ? shadow_add(newp, size, index, tracenum, i) == 0 :
+		add_range(ranges, newp, size, tracenum, i) == 0)
 		return 0;
 	    
 	    /* ADDED: cgw
@@ -653,13 +1492,15 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    oldsize = trace->block_sizes[index];
 	    if (size < oldsize) oldsize = size;
 	    for (j = 0; j < oldsize; j++) {
-	      if (newp[j] != (index & 0xFF)) {
+	      if (newp[j] != (char)(index & 0xFF)) {
 		malloc_error(tracenum, i, "mm_realloc did not preserve the "
 			     "data from old block");
 		return 0;
 	      }
 	    }
 	    memset(newp, index & 0xFF, size);
+	    if (check_usable(newp, size, tracenum, i) == 0)
+		return 0;
 
 	    /* Remember region */
 	    trace->blocks[index] = newp;
@@ -670,20 +1511,135 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    
 	    /* Remove region from list and call student's free function */
 	    p = trace->blocks[index];
-	    remove_range(ranges, p);
-	    mm_free(p);
+	    if (use_shadow) {
+		if (shadow_remove(p, trace->block_sizes[index], index, 
+				  tracenum, i) == 0)
+		    return 0;
+	    }
+	    else
+		remove_range(ranges, p);
+	    if (mm_pkg->free_sized && !use_batch)
+		mm_pkg->free_sized(p, trace->block_sizes[index]);
+	    else
+		batch_free(trace, i, trace->num_ops, p);
 	    break;
 
 	default:
 	    app_error("Nonexistent request type in eval_mm_valid");
         }
 
+	/* Check the heap: the touched blocks after every request, and
+	   the whole heap every check_every requests and at the end */
+	if (check_every && mm_pkg->check) {
+	    full = ((i + 1) % check_every == 0 || i == trace->num_ops - 1);
+	    if (mm_pkg->check(full, 1) > 0) {
+		malloc_error(tracenum, i, full ? "mm_check found the heap "
+			     "inconsistent." : "mm_check found the blocks "
+			     "touched by this request inconsistent.");
+		return 0;
+	    }
+	}
     }
 
     /* As far as we know, this is a valid malloc package */
     return 1;
 }
 
+/*
+ * check_usable - If the package reports usable sizes, check that the
+ *     block p of size bytes is at least that large, and write to its 
+ *     slack, so that an overstated usable size shows up as clobbered
+ *     neighbours or allocator metadata
+ */
+static int check_usable(char *p, int size, int tracenum, int opnum)
+{
+    size_t usable;
+
+    if (mm_pkg->usable_size == NULL)
+	return 1;
+    if ((usable = mm_pkg->usable_size(p)) < (size_t)size) {
+	sprintf(msg, "mm_usable_size(%p) is %lu, less than the %d bytes "
+		"requested", p, (unsigned long)usable, size);
+	malloc_error(tracenum, opnum, msg);
+	return 0;
+    }
+    memset(p + size, 0xFF, usable - size);
+    return 1;
+}
+
+/*
+ * alloc_op - Allocate the block of the ALLOC request op, passing its
+ *     lifetime hint if -L is set and the package takes hints
+ */
+static void *alloc_op(traceop_t *op)
+{
+    if (use_hints && mm_pkg->malloc_hint != NULL)
+	return mm_pkg->malloc_hint(op->size, op->hint);
+    return mm_pkg->malloc(op->size);
+}
+
+/*
+ * batch_alloc - Allocate the block of ALLOC request i. With -B, the
+ *     first of a run of same-size ALLOCs before request end allocates
+ *     the whole run with one malloc_batch call, and the rest of the
+ *     run take their blocks from it in order
+ */
+static void *batch_alloc(trace_t *trace, int i, int end)
+{
+    static void *blocks[BATCH_MAX];
+    static trace_t *run_trace = NULL;  /* the run being handed out... */
+    static int run_next = 0;           /* ... the request that is next... */
+    static int next = 0, n = 0;        /* ... and its next block */
+    int size = trace->ops[i].size;
+
+    if (!use_batch || mm_pkg->malloc_batch == NULL)
+	return alloc_op(&trace->ops[i]);
+
+    /* Start a new run, dropping what is left of one that was cut short */
+    if (next == n || trace != run_trace || i != run_next) {
+	for (n = 1; n < BATCH_MAX && i + n < end &&
+		 trace->ops[i + n].type == ALLOC &&
+		 trace->ops[i + n].size == size; n++)
+	    ;
+	next = 0;
+	run_trace = trace;
+	if (mm_pkg->malloc_batch(size, n, blocks) != n) {
+	    n = 0;
+	    return NULL;
+	}
+    }
+    run_next = i + 1;
+    return blocks[next++];
+}
+
+/*
+ * batch_free - Free block p of FREE request i. With -B, the frees of a
+ *     run of FREEs are held back until its last request (or the one
+ *     before end), and then go to the package in one free_batch call
+ */
+static void batch_free(trace_t *trace, int i, int end, void *p)
+{
+    static void *blocks[BATCH_MAX];
+    static trace_t *run_trace = NULL;
+    static int run_next = 0, n = 0;
+
+    if (!use_batch || mm_pkg->free_batch == NULL) {
+	mm_pkg->free(p);
+	return;
+    }
+
+    /* Blocks held back by a replay that stopped early are long gone */
+    if (trace != run_trace || i != run_next)
+	n = 0;
+    blocks[n++] = p;
+    run_trace = trace;
+    run_next = i + 1;
+    if (n == BATCH_MAX || i + 1 == end || trace->ops[i + 1].type != FREE) {
+	mm_pkg->free_batch(blocks, n);
+	n = 0;
+    }
+}
+
 /* 
  * eval_mm_util - Evaluate the space utilization of the student's package
  *   The idea is to remember the high water mark "hwm" of the heap for 
@@ -707,7 +1663,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 
     /* initialize the heap and the mm malloc package */
     mem_reset_brk();
-    if (mm_init() < 0)
+    if (mm_pkg->init() < 0)
 	app_error("mm_init failed in eval_mm_util");
 
     for (i = 0;  i < trace->num_ops;  i++) {
@@ -717,7 +1673,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    index = trace->ops[i].index;
 	    size = trace->ops[i].size;
 
-	    if ((p = mm_malloc(size)) == NULL) 
+	    if ((p = batch_alloc(trace, i, trace->num_ops)) == NULL) 
 		app_error("mm_malloc failed in eval_mm_util");
 	    
 	    /* Remember region and size */
@@ -739,7 +1695,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    oldsize = trace->block_sizes[index];
 
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp,newsize)) == NULL)
+	    if ((newp = mm_pkg->realloc(oldp,newsize)) == NULL)
 		app_error("mm_realloc failed in eval_mm_util");
 
 	    /* Remember region and size */
@@ -760,7 +1716,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    size = trace->block_sizes[index];
 	    p = trace->blocks[index];
 	    
-	    mm_free(p);
+	    batch_free(trace, i, trace->num_ops, p);
 	    
 	    /* Keep track of current total size
 	     * of all allocated blocks */
@@ -779,28 +1735,33 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 
 
 /*
- * eval_mm_speed - This is the function that is used by fcyc()
+ * eval_mm_speed - This is the function that is used by bench_run()
  *    to measure the running time of the mm malloc package.
  */
 static void eval_mm_speed(void *ptr)
 {
-    int i, index, size, newsize;
+    int i, index, newsize;
     char *p, *newp, *oldp, *block;
-    trace_t *trace = ((speed_t *)ptr)->trace;
+    speed_t *params = (speed_t *)ptr;
+    trace_t *trace = params->trace;
 
-    /* Reset the heap and initialize the mm package */
-    mem_reset_brk();
-    if (mm_init() < 0) 
-	app_error("mm_init failed in eval_mm_speed");
+    /* 
+     * Reset the heap and initialize the mm package, unless the window
+     * starts later: then restore_window has already set up the heap
+     */
+    if (params->from == 0) {
+	mem_reset_brk();
+	if (mm_pkg->init() < 0) 
+	    app_error("mm_init failed in eval_mm_speed");
+    }
 
     /* Interpret each trace request */
-    for (i = 0;  i < trace->num_ops;  i++)
+    for (i = params->from;  i < params->to;  i++)
         switch (trace->ops[i].type) {
 
         case ALLOC: /* mm_malloc */
             index = trace->ops[i].index;
-            size = trace->ops[i].size;
-            if ((p = mm_malloc(size)) == NULL)
+            if ((p = batch_alloc(trace, i, params->to)) == NULL)
 		app_error("mm_malloc error in eval_mm_speed");
             trace->blocks[index] = p;
             break;
@@ -809,7 +1770,7 @@ static void eval_mm_speed(void *ptr)
 	    index = trace->ops[i].index;
             newsize = trace->ops[i].size;
 	    oldp = trace->blocks[index];
-            if ((newp = mm_realloc(oldp,newsize)) == NULL)
+            if ((newp = mm_pkg->realloc(oldp,newsize)) == NULL)
 		app_error("mm_realloc error in eval_mm_speed");
             trace->blocks[index] = newp;
             break;
@@ -817,7 +1778,7 @@ static void eval_mm_speed(void *ptr)
         case FREE: /* mm_free */
             index = trace->ops[i].index;
             block = trace->blocks[index];
-            mm_free(block);
+            batch_free(trace, i, params->to, block);
             break;
 
 	default:
@@ -826,32 +1787,742 @@ static void eval_mm_speed(void *ptr)
 }
 
 /*
- * eval_libc_valid - We run this function to make sure that the
- *    libc malloc can run to completion on the set of traces.
- *    We'll be conservative and terminate if any libc malloc call fails.
- *
+ * warm_window - Set up params so that eval_mm_speed only replays the
+ *    requests from lo to hi percent into the trace. The requests before
+ *    the window are replayed once, here, and the heap, the package's
+ *    state and the block pointers are saved at that point, so that
+ *    restore_window can go back to it before every timed run. Returns
+ *    0, and leaves the whole trace to be timed, if there is no window
+ *    or the package can't take snapshots. A package that can, but
+ *    fails to (mm.c with guard pages up), is an error: falling back
+ *    would time some traces whole and others in part.
  */
-static int eval_libc_valid(trace_t *trace, int tracenum)
+static int warm_window(speed_t *params, int lo, int hi)
 {
-    int i, newsize;
-    char *p, *newp, *oldp;
+    trace_t *trace = params->trace;
+    int from = (int)((double)trace->num_ops * lo / 100);
+    int to = (int)((double)trace->num_ops * hi / 100);
 
-    for (i = 0;  i < trace->num_ops;  i++) {
-        switch (trace->ops[i].type) {
+    if (lo == 0 && hi == 100)
+	return 0;
+    if (from > 0) {
+	if (mm_pkg->snapshot == NULL)
+	    return 0;
+	params->to = from;
+	eval_mm_speed(params);
+	params->to = trace->num_ops;
+	if (mm_pkg->snapshot() < 0 || mem_snapshot() < 0) {
+	    sprintf(msg, "Could not take a snapshot of %s malloc for -W",
+		    mm_pkg->name);
+	    app_error(msg);
+	}
+	params->blocks = (char **)realloc(params->blocks, 
+					  trace->num_ids * sizeof(char *));
+	if (params->blocks == NULL)
+	    unix_error("blocks realloc in warm_window failed");
+	memcpy(params->blocks, trace->blocks, trace->num_ids * sizeof(char *));
+    }
+    params->from = from;
+    params->to = to;
+    if (verbose > 1)
+	printf("Timing requests %d to %d of %d.\n", from, to, 
+	       trace->num_ops);
+    return 1;
+}
 
-        case ALLOC: /* malloc */
-	    if ((p = malloc(trace->ops[i].size)) == NULL) {
-		malloc_error(tracenum, i, "libc malloc failed");
-		unix_error("System message");
-	    }
-	    trace->blocks[trace->ops[i].index] = p;
-	    break;
+/*
+ * restore_window - bench_run setup hook: go back to the snapshot that
+ *    warm_window took at the start of the window. With -X, the hook
+ *    runs in the forked child, and first drops the heap's pages, so
+ *    that the run pays first-touch faults rather than copy-on-write
+ *    faults on the pages that the parent left behind.
+ */
+static void restore_window(void *ptr)
+{
+    speed_t *params = (speed_t *)ptr;
+    trace_t *trace = params->trace;
+
+    if (fresh_heap)
+	mem_release();
+    if (params->from == 0)
+	return;
+    mm_pkg->restore();
+    mem_restore();
+    memcpy(trace->blocks, params->blocks, trace->num_ids * sizeof(char *));
+}
 
-	case REALLOC: /* realloc */
-            newsize = trace->ops[i].size;
-	    oldp = trace->blocks[trace->ops[i].index];
-	    if ((newp = realloc(oldp, newsize)) == NULL) {
-		malloc_error(tracenum, i, "libc realloc failed");
+/*
+ * counter_overhead - Estimate the cost of one read_counter() call in
+ *    ticks, as the smallest difference between back-to-back reads.
+ */
+static unsigned long long counter_overhead(void)
+{
+    unsigned long long t0, t1, best = ~0ULL;
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+	t0 = read_counter();
+	t1 = read_counter();
+	if (t1 - t0 < best)
+	    best = t1 - t0;
+    }
+    return best;
+}
+
+/*
+ * eval_mm_latency - Time every request of the trace individually and
+ *    record the latencies in one histogram per request type. To keep
+ *    the timer overhead small, each counter read both ends one request
+ *    and starts the next, and the raw deltas are only folded into the
+ *    histograms as a batch once the replay is over. The trace is
+ *    replayed LAT_RUNS times to collect enough samples for the tails.
+ */
+static void eval_mm_latency(trace_t *trace, lathist_t *hists)
+{
+    int i, run, index;
+    unsigned long long t0, t1, ovh;
+    unsigned int *lat;
+    char *p;
+
+    if ((lat = (unsigned int *)malloc(trace->num_ops * sizeof(unsigned int)))
+	== NULL)
+	unix_error("malloc failed in eval_mm_latency");
+    ovh = counter_overhead();
+
+    for (run = 0; run < LAT_RUNS; run++) {
+	mem_reset_brk();
+	if (mm_pkg->init() < 0)
+	    app_error("mm_init failed in eval_mm_latency");
+
+	t0 = read_counter();
+	for (i = 0;  i < trace->num_ops;  i++) {
+	    index = trace->ops[i].index;
+	    switch (trace->ops[i].type) {
+	    case ALLOC: /* mm_malloc */
+		if ((p = alloc_op(&trace->ops[i])) == NULL)
+		    app_error("mm_malloc error in eval_mm_latency");
+		trace->blocks[index] = p;
+		break;
+
+	    case REALLOC: /* mm_realloc */
+		if ((p = mm_pkg->realloc(trace->blocks[index], 
+				    trace->ops[i].size)) == NULL)
+		    app_error("mm_realloc error in eval_mm_latency");
+		trace->blocks[index] = p;
+		break;
+
+	    case FREE: /* mm_free */
+		mm_pkg->free(trace->blocks[index]);
+		break;
+
+	    default:
+		app_error("Nonexistent request type in eval_mm_latency");
+	    }
+	    t1 = read_counter();
+	    lat[i] = (t1 - t0 > 0xffffffffULL) ? 0xffffffff : 
+		(unsigned int)(t1 - t0);
+	    t0 = t1;
+	}
+
+	/* Fold the batch of raw deltas into the histograms */
+	for (i = 0;  i < trace->num_ops;  i++)
+	    lh_record(&hists[trace->ops[i].type], 
+		      (lat[i] > ovh) ? lat[i] - ovh : 0);
+    }
+    free(lat);
+}
+
+/*
+ * eval_mm_quality - Check the current package for correctness on a 
+ *    trace and, if it passes, measure its space utilization 
+ */
+static void eval_mm_quality(trace_t *trace, int tracenum, range_t **ranges,
+			    stats_t *stats)
+{
+    if (verbose > 1)
+	printf("Checking %s malloc for correctness, ", mm_pkg->name);
+    stats->valid = eval_mm_valid(trace, tracenum, ranges);
+    if (stats->valid) {
+	if (verbose > 1)
+	    printf("efficiency.\n");
+	stats->util = eval_mm_util(trace, tracenum, ranges);
+	stats->sbrks = mem_sbrkcalls();
+	stats->heap = mem_heapsize();
+    }
+    else if (verbose > 1)
+	printf("failed.\n");
+}
+
+/*
+ * region_end - Is request i of a trace the last free of a region destroy?
+ */
+static int region_end(trace_t *trace, int i)
+{
+    traceop_t *op = &trace->ops[i];
+
+    return (i + 1 == trace->num_ops || op[1].type != FREE || 
+	    op[1].region != op->region);
+}
+
+/*
+ * eval_mm_region_valid - Replays a trace with the region API of mm.c 
+ *     for its region requests, and the mm package for the rest. Each
+ *     block is filled with the low byte of its id like in eval_mm_valid,
+ *     and the blocks of a region are checked when it is destroyed, which
+ *     catches overlaps between region blocks and everything else.
+ */
+static int eval_mm_region_valid(trace_t *trace, int tracenum)
+{
+    int i, j, index, size;
+    char *p;
+    traceop_t *op;
+
+    mem_reset_brk();
+    if (mm_pkg->init() < 0) {
+	malloc_error(tracenum, 0, "mm_init failed.");
+	return 0;
+    }
+    memset(trace->regions, 0, trace->num_regions * sizeof(region_t *));
+
+    for (i = 0; i < trace->num_ops; i++) {
+	op = &trace->ops[i];
+	index = op->index;
+	size = op->size;
+	switch (op->type) {
+	case ALLOC:
+	    if (op->region < 0)
+		p = mm_pkg->malloc(size);
+	    else {
+		if (trace->regions[op->region] == NULL &&
+		    (trace->regions[op->region] = mm_region_create(0)) == NULL) {
+		    malloc_error(tracenum, i, "mm_region_create failed.");
+		    return 0;
+		}
+		p = mm_region_alloc(trace->regions[op->region], size);
+	    }
+	    if (p == NULL) {
+		malloc_error(tracenum, i, "allocation failed.");
+		return 0;
+	    }
+	    if (!IS_ALIGNED(p) || p < (char *)mem_heap_lo() || 
+		p + size - 1 > (char *)mem_heap_hi()) {
+		sprintf(msg, "Payload (%p) misaligned or outside the heap", p);
+		malloc_error(tracenum, i, msg);
+		return 0;
+	    }
+	    memset(p, index & 0xFF, size);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+	case REALLOC:
+	    if ((p = mm_pkg->realloc(trace->blocks[index], size)) == NULL) {
+		malloc_error(tracenum, i, "mm_realloc failed.");
+		return 0;
+	    }
+	    memset(p, index & 0xFF, size);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+	case FREE:
+	    p = trace->blocks[index];
+	    for (j = 0; j < trace->block_sizes[index]; j++)
+		if (p[j] != (char)(index & 0xFF)) {
+		    sprintf(msg, "Payload of block %d was overwritten at %p",
+			    index, p + j);
+		    malloc_error(tracenum, i, msg);
+		    return 0;
+		}
+	    if (op->region < 0)
+		mm_pkg->free(p);
+	    else if (region_end(trace, i)) {
+		mm_region_destroy(trace->regions[op->region]);
+		trace->regions[op->region] = NULL;
+	    }
+	    break;
+
+	default:
+	    app_error("Nonexistent request type in eval_mm_region_valid");
+	}
+    }
+    if (mm_pkg->check && mm_pkg->check(1, 1) > 0) {
+	malloc_error(tracenum, trace->num_ops - 1, 
+		     "mm_check found the heap inconsistent.");
+	return 0;
+    }
+    return 1;
+}
+
+/*
+ * eval_mm_region_speed - Like eval_mm_speed, but with the region API 
+ *     for the region requests: a region destroy frees all of its blocks
+ *     at once instead of one by one
+ */
+static void eval_mm_region_speed(void *ptr)
+{
+    int i;
+    char *p;
+    traceop_t *op;
+    trace_t *trace = ((speed_t *)ptr)->trace;
+    region_t **regions = trace->regions;
+
+    mem_reset_brk();
+    if (mm_pkg->init() < 0) 
+	app_error("mm_init failed in eval_mm_region_speed");
+    memset(regions, 0, trace->num_regions * sizeof(region_t *));
+
+    for (i = 0; i < trace->num_ops; i++) {
+	op = &trace->ops[i];
+	switch (op->type) {
+	case ALLOC:
+	    if (op->region < 0)
+		p = mm_pkg->malloc(op->size);
+	    else {
+		if (regions[op->region] == NULL)
+		    regions[op->region] = mm_region_create(0);
+		p = mm_region_alloc(regions[op->region], op->size);
+	    }
+	    if (p == NULL)
+		app_error("allocation error in eval_mm_region_speed");
+	    trace->blocks[op->index] = p;
+	    break;
+
+	case REALLOC:
+	    if ((p = mm_pkg->realloc(trace->blocks[op->index], op->size)) 
+		== NULL)
+		app_error("mm_realloc error in eval_mm_region_speed");
+	    trace->blocks[op->index] = p;
+	    break;
+
+	case FREE:
+	    if (op->region < 0)
+		mm_pkg->free(trace->blocks[op->index]);
+	    else if (region_end(trace, i)) {
+		mm_region_destroy(regions[op->region]);
+		regions[op->region] = NULL;
+	    }
+	    break;
+
+	default:
+	    app_error("Nonexistent request type in eval_mm_region_speed");
+	}
+    }
+}
+
+/*
+ * replay_sampled - Replays a trace with the current package, like
+ *    eval_mm_util, and calls sample after every request. Entries of
+ *    trace->blocks are NULL while their block is not allocated.
+ */
+static void replay_sampled(trace_t *trace, sampler_t sample, void *arg)
+{
+    int i, index;
+    size_t live = 0;
+    char *p;
+
+    memset(trace->blocks, 0, trace->num_ids * sizeof(char *));
+    mem_reset_brk();
+    if (mm_pkg->init() < 0)
+	app_error("mm_init failed in replay_sampled");
+
+    for (i = 0; i < trace->num_ops; i++) {
+	index = trace->ops[i].index;
+	switch (trace->ops[i].type) {
+	case ALLOC:
+	    if ((p = alloc_op(&trace->ops[i])) == NULL)
+		app_error("mm_malloc failed in replay_sampled");
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = trace->ops[i].size;
+	    live += trace->ops[i].size;
+	    break;
+	case REALLOC:
+	    p = mm_pkg->realloc(trace->blocks[index], trace->ops[i].size);
+	    if (p == NULL)
+		app_error("mm_realloc failed in replay_sampled");
+	    live += trace->ops[i].size - trace->block_sizes[index];
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = trace->ops[i].size;
+	    break;
+	case FREE:
+	    mm_pkg->free(trace->blocks[index]);
+	    trace->blocks[index] = NULL;
+	    live -= trace->block_sizes[index];
+	    break;
+	default:
+	    app_error("Nonexistent request type in replay_sampled");
+	}
+	sample(trace, i, live, arg);
+    }
+}
+
+/*
+ * frag_sample - Sampler of eval_mm_frag: walks the heap every 
+ *    interval requests, at the peak and at the end of the trace
+ */
+static void frag_sample(trace_t *trace, int op, size_t live, void *arg)
+{
+    fragsampler_t *fs = (fragsampler_t *)arg;
+    int row = ((op + 1) % fs->interval == 0 || op == trace->num_ops - 1);
+    int id;
+
+    if (!row && op != fs->peak)
+	return;
+    hm_init(&fs->hm, mem_heap_lo(), mem_heapsize(), fs->maxheap);
+    mm_pkg->walk(hm_block, &fs->hm);
+    for (id = 0; id < trace->num_ids; id++)
+	if (trace->blocks[id])
+	    hm_payload(&fs->hm, trace->blocks[id], trace->block_sizes[id]);
+    if (op == fs->peak)
+	fs->peak_hm = fs->hm;
+    if (row && fs->pgm)
+	hm_write_pgm(fs->fp, &fs->hm);
+    else if (row) {
+	fprintf(fs->fp, "%8d |", op + 1);
+	hm_write_text(fs->fp, &fs->hm);
+    }
+}
+
+/*
+ * eval_mm_frag - Replays a trace, prints where the heap goes at the 
+ *    peak payload (the numerator of the utilization) and draws a heap
+ *    map row every interval requests. PGM maps (mapfile ending in 
+ *    ".pgm") get one image per package and trace, text maps are 
+ *    appended to mapfile.
+ */
+static void eval_mm_frag(trace_t *trace, int tracenum, char *file, 
+			 size_t maxheap, int interval, char *mapfile)
+{
+    fragsampler_t fs;
+    char path[MAXLINE];
+    size_t len = strlen(mapfile), live = 0, peak = 0;
+    size_t *sizes;
+    int i, rows;
+    static int first = 1;
+
+    memset(&fs, 0, sizeof(fs));
+    fs.maxheap = maxheap;
+    fs.interval = interval ? interval : 
+	(trace->num_ops + MAP_ROWS - 1) / MAP_ROWS;
+    rows = (trace->num_ops + fs.interval - 1) / fs.interval;
+
+    /* Find the request after which the payload peaks */
+    if ((sizes = (size_t *)calloc(trace->num_ids, sizeof(size_t))) == NULL)
+	unix_error("calloc failed in eval_mm_frag");
+    for (i = 0; i < trace->num_ops; i++) {
+	live -= sizes[trace->ops[i].index];
+	sizes[trace->ops[i].index] = 
+	    (trace->ops[i].type == FREE) ? 0 : trace->ops[i].size;
+	live += sizes[trace->ops[i].index];
+	if (live > peak) {
+	    peak = live;
+	    fs.peak = i;
+	}
+    }
+    free(sizes);
+
+    /* Open the heap map */
+    fs.pgm = (len > 4 && !strcmp(mapfile + len - 4, ".pgm"));
+    if (fs.pgm) {
+	sprintf(path, "%.*s-%s-%d.pgm", (int)(len - 4), mapfile, 
+		mm_pkg->name, tracenum);
+	fs.fp = fopen(path, "w");
+    }
+    else {
+	strcpy(path, mapfile);
+	fs.fp = fopen(path, first ? "w" : "a");
+	first = 0;
+    }
+    if (fs.fp == NULL) {
+	sprintf(msg, "Could not open %s in eval_mm_frag", path);
+	unix_error(msg);
+    }
+    if (fs.pgm)
+	fprintf(fs.fp, "P2\n# %s malloc, trace %d (%s)\n%d %d\n255\n",
+		mm_pkg->name, tracenum, file, HM_WIDTH, rows);
+    else
+	fprintf(fs.fp, "# %s malloc, trace %d (%s): %d cells of %lu bytes\n"
+		"# '#' payload, '+' fragmentation or overhead, '.' free\n"
+		"%8s |\n", mm_pkg->name, tracenum, file, HM_WIDTH,
+		(unsigned long)((maxheap + HM_WIDTH - 1) / HM_WIDTH), "request");
+
+    replay_sampled(trace, frag_sample, &fs);
+    if (!fs.pgm)
+	fprintf(fs.fp, "\n");
+    fclose(fs.fp);
+
+    printf("Fragmentation of %s malloc on trace %d at its peak payload "
+	   "(request %d):\n", mm_pkg->name, tracenum, fs.peak + 1);
+    hm_print(&fs.peak_hm);
+    printf("\n");
+}
+
+/* free_bytes - mm_walk callback that adds up the free blocks */
+static void free_bytes(void *blk, size_t size, int alloc, void *arg)
+{
+    if (!alloc)
+	*(size_t *)arg += size;
+}
+
+/*
+ * series_sample - Sampler of eval_mm_series: accumulates the time
+ *    averages after every request and writes a sample every interval
+ *    requests and at the end of the trace
+ */
+static void series_sample(trace_t *trace, int op, size_t live, void *arg)
+{
+    seriessampler_t *ss = (seriessampler_t *)arg;
+    size_t heap = mem_heapsize(), free = 0;
+    char freestr[32];
+
+    ss->util_sum += heap ? (double)live / heap : 0.0;
+    ss->live_sum += live;
+    if (heap > ss->peak_heap)
+	ss->peak_heap = heap;
+    if (live > ss->peak_live)
+	ss->peak_live = live;
+    if ((op + 1) % ss->interval != 0 && op != trace->num_ops - 1)
+	return;
+
+    /* Free bytes need a heap walk; packages without one report null */
+    strcpy(freestr, "");
+    if (mm_pkg->walk) {
+	mm_pkg->walk(free_bytes, &free);
+	sprintf(freestr, "%lu", (unsigned long)free);
+    }
+    if (ss->first)
+	fprintf(ss->fp, "%s  {\"allocator\": \"%s\", \"trace\": %d, "
+		"\"file\": \"%s\", \"op\": %d, \"live\": %lu, "
+		"\"heap\": %lu, \"free\": %s}", *ss->first ? "" : ",\n", 
+		mm_pkg->name, ss->tracenum, ss->file, op + 1, 
+		(unsigned long)live, (unsigned long)heap, 
+		mm_pkg->walk ? freestr : "null");
+    else
+	fprintf(ss->fp, "%s,%d,%s,%d,%lu,%lu,%s\n", mm_pkg->name, 
+		ss->tracenum, ss->file, op + 1, (unsigned long)live, 
+		(unsigned long)heap, freestr);
+    if (ss->first)
+	*ss->first = 0;
+}
+
+/*
+ * eval_mm_series - Replays a trace and records the live payload, heap
+ *    size and free bytes over time. The averages over all requests go
+ *    into stats, and a sample every interval requests (default: 
+ *    SERIES_POINTS per trace) into fp, as JSON records if first is 
+ *    not NULL and as CSV lines otherwise.
+ */
+static void eval_mm_series(trace_t *trace, int tracenum, char *file, 
+			   int interval, FILE *fp, int *first, stats_t *stats)
+{
+    seriessampler_t ss;
+
+    memset(&ss, 0, sizeof(ss));
+    ss.fp = fp;
+    ss.first = first;
+    ss.tracenum = tracenum;
+    ss.file = file;
+    ss.interval = interval ? interval : 
+	(trace->num_ops + SERIES_POINTS - 1) / SERIES_POINTS;
+
+    replay_sampled(trace, series_sample, &ss);
+    stats->util_avg = ss.util_sum / trace->num_ops;
+    stats->live_avg = ss.live_sum / trace->num_ops;
+    stats->peak_live = ss.peak_live;
+}
+
+/*
+ * measure_speed - Time f with bench_run and record the median running
+ *     time and its spread in stats
+ */
+static void measure_speed(bench_funct f, speed_t *params, 
+			  bench_params_t *bench, stats_t *stats)
+{
+    bench_params_t p = *bench;
+    bench_result_t r;
+
+    p.setup = restore_window;
+    bench_run(f, params, &p, &r);
+    stats->runs = r.samples;
+    stats->secs = r.median;
+    stats->secs_sd = r.sd;
+    stats->secs_mad = r.mad;
+    stats->secs_lo = r.lo;
+    stats->secs_hi = r.hi;
+    stats->faults = r.faults;
+    if (verbose > 1)
+	printf("%d warmup runs, %d samples (%d outliers), "
+	       "median %.6f secs [%.6f, %.6f], %.0f page faults\n", r.warmup,
+	       r.samples, r.outliers, r.median, r.lo, r.hi, r.faults);
+}
+
+/*
+ * count_events - Run f once more with the hardware counters on. This
+ *     stays out of measure_speed, so that the counters never add to
+ *     the measured times.
+ */
+static void count_events(bench_funct f, speed_t *params, 
+			 stats_t *stats)
+{
+    restore_window(params);
+    pc_start();
+    f(params);
+    pc_stop(stats->events);
+}
+
+/* evict_caches - bench_run setup hook of measure_cold, after restore_window */
+static void evict_caches(void *argp)
+{
+    restore_window(argp);
+    cache_evict();
+}
+
+/*
+ * measure_cold - Time f like measure_speed, but evict all data caches
+ *     before every sample, as if the allocator were called from cold
+ *     code. Sweeping the caches is slow, so take fewer samples.
+ */
+static void measure_cold(bench_funct f, speed_t *params, 
+			 bench_params_t *bench, stats_t *stats)
+{
+    bench_params_t p = *bench;
+    bench_result_t r;
+
+    p.setup = evict_caches;
+    if (p.max_samples > COLD_SAMPLES)
+	p.max_samples = (p.min_samples > COLD_SAMPLES) ? 
+	    p.min_samples : COLD_SAMPLES;
+    bench_run(f, params, &p, &r);
+    stats->secs_cold = r.median;
+    if (verbose > 1)
+	printf("Cold caches: %d samples (%d outliers), median %.6f secs "
+	       "[%.6f, %.6f]\n", r.samples, r.outliers, r.median, r.lo, r.hi);
+}
+
+/*
+ * mt_worker - One thread of the multithreaded replay engine. It issues
+ *    the requests of its thread in trace order. Before each request it
+ *    waits until all earlier requests on the same id, from whatever 
+ *    thread, have completed, which keeps the cross-thread ordering of 
+ *    the trace (e.g., a consumer's free after the producer's malloc).
+ */
+static void *mt_worker(void *arg)
+{
+    mtthread_t *t = (mtthread_t *)arg;
+    trace_t *trace = t->trace;
+    traceop_t *op;
+    char *p;
+    int k;
+
+    for (k = 0; k < trace->thread_nops[t->tid]; k++) {
+	op = &trace->ops[trace->thread_ops[t->tid][k]];
+	while (__atomic_load_n(&trace->done[op->index], __ATOMIC_ACQUIRE) 
+	       != op->seq)
+	    sched_yield();
+
+	if (t->locked)
+	    pthread_mutex_lock(&mt_lock);
+	switch (op->type) {
+	case ALLOC:
+	    if ((p = t->pkg->malloc(op->size)) == NULL)
+		app_error("malloc failed in mt_worker");
+	    trace->blocks[op->index] = p;
+	    break;
+
+	case REALLOC:
+	    if ((p = t->pkg->realloc(trace->blocks[op->index], op->size)) 
+		== NULL)
+		app_error("realloc failed in mt_worker");
+	    trace->blocks[op->index] = p;
+	    break;
+
+	case FREE:
+	    t->pkg->free(trace->blocks[op->index]);
+	    break;
+	}
+	if (t->locked)
+	    pthread_mutex_unlock(&mt_lock);
+
+	__atomic_store_n(&trace->done[op->index], op->seq + 1, 
+			 __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/*
+ * mt_replay - Replay a multithreaded trace with one pthread per trace 
+ *    thread, all calling into pkg
+ */
+static void mt_replay(trace_t *trace, allocator_t *pkg, int locked)
+{
+    pthread_t tids[MAXTHREADS];
+    mtthread_t args[MAXTHREADS];
+    int tid;
+
+    memset(trace->done, 0, trace->num_ids * sizeof(int));
+    for (tid = 0; tid < trace->num_threads; tid++) {
+	args[tid].trace = trace;
+	args[tid].pkg = pkg;
+	args[tid].locked = locked;
+	args[tid].tid = tid;
+	if (pthread_create(&tids[tid], NULL, mt_worker, &args[tid]) != 0)
+	    app_error("pthread_create failed in mt_replay");
+    }
+    for (tid = 0; tid < trace->num_threads; tid++)
+	pthread_join(tids[tid], NULL);
+}
+
+/*
+ * eval_mm_mtspeed - Like eval_mm_speed, for multithreaded traces. The
+ *    packages in allocators are not thread-safe, so the engine holds
+ *    a global lock around every call into them; the measured time then
+ *    includes the cost of the lock and of the contention for it.
+ */
+static void eval_mm_mtspeed(void *ptr)
+{
+    trace_t *trace = ((speed_t *)ptr)->trace;
+
+    mem_reset_brk();
+    if (mm_pkg->init() < 0) 
+	app_error("mm_init failed in eval_mm_mtspeed");
+    mt_replay(trace, mm_pkg, 1);
+}
+
+/*
+ * eval_libc_mtspeed - Like eval_libc_speed, for multithreaded traces
+ */
+static void eval_libc_mtspeed(void *ptr)
+{
+    mt_replay(((speed_t *)ptr)->trace, &libc_pkg, 0);
+}
+
+/*
+ * eval_libc_valid - We run this function to make sure that the
+ *    libc malloc can run to completion on the set of traces.
+ *    We'll be conservative and terminate if any libc malloc call fails.
+ *
+ */
+static int eval_libc_valid(trace_t *trace, int tracenum)
+{
+    int i, newsize;
+    char *p, *newp, *oldp;
+
+    for (i = 0;  i < trace->num_ops;  i++) {
+        switch (trace->ops[i].type) {
+
+        case ALLOC: /* malloc */
+	    if ((p = malloc(trace->ops[i].size)) == NULL) {
+		malloc_error(tracenum, i, "libc malloc failed");
+		unix_error("System message");
+	    }
+	    trace->blocks[trace->ops[i].index] = p;
+	    break;
+
+	case REALLOC: /* realloc */
+            newsize = trace->ops[i].size;
+	    oldp = trace->blocks[trace->ops[i].index];
+	    if ((newp = realloc(oldp, newsize)) == NULL) {
+		malloc_error(tracenum, i, "libc realloc failed");
 		unix_error("System message");
 	    }
 	    trace->blocks[trace->ops[i].index] = newp;
@@ -870,7 +2541,7 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 }
 
 /* 
- * eval_libc_speed - This is the function that is used by fcyc() to
+ * eval_libc_speed - This is the function that is used by bench_run() to
  *    measure the running time of the libc malloc package on the set
  *    of traces.
  */
@@ -972,6 +2643,739 @@ static void printresults(int n, stats_t *stats)
 
 }
 
+/**********************************************************************
+ * The following functions evaluate correctness and utilization in a
+ * pool of worker processes (-j), away from the CPU used for timing.
+ **********************************************************************/
+
+/*
+ * init_timer - Calibrate the counter that bench_run and the latency
+ *     histograms read, so that no timed run pays for it
+ */
+static void init_timer(void)
+{
+#if defined(__i386__) || defined(__x86_64__) || defined(__alpha)
+    if (verbose)
+	printf("Measuring performance with a cycle counter.\n");
+    if (!counter_invariant())
+	printf("Warning: the cycle counter rate varies with the clock speed.\n");
+    mhz_calibrate(verbose > 0);
+#else
+    if (verbose)
+	printf("Measuring performance with clock_gettime().\n");
+#endif
+}
+
+/*
+ * pin_to_cpu - Restrict the calling process to a single CPU
+ */
+static void pin_to_cpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0 && verbose > 1)
+	printf("Could not pin to CPU %d: %s\n", cpu, strerror(errno));
+#endif
+}
+
+/*
+ * list_cpus - Store the CPUs this process may run on in cpus and return
+ *     their number (1, with cpus[0] = -1, if that is unknown)
+ */
+static int list_cpus(int *cpus, int max)
+{
+    int n = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    int cpu;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+	for (cpu = 0; cpu < CPU_SETSIZE && n < max; cpu++)
+	    if (CPU_ISSET(cpu, &set))
+		cpus[n++] = cpu;
+#endif
+    if (n == 0)
+	cpus[n++] = -1;
+    return n;
+}
+
+/*
+ * reap_worker - Wait for one worker to exit and collect its result
+ */
+static void reap_worker(pid_t *pids, int *fds, int n, stats_t **pkg_stats)
+{
+    jobresult_t res;
+    stats_t *st;
+    pid_t pid;
+    int j, status;
+
+    if ((pid = wait(&status)) < 0)
+	unix_error("wait failed in reap_worker");
+    for (j = 0; pids[j] != pid; j++)
+	;
+    st = &pkg_stats[j / n][j % n];
+    if (read(fds[j], &res, sizeof(res)) == sizeof(res)) {
+	st->valid = res.valid;
+	st->util = res.util;
+	st->sbrks = res.sbrks;
+	st->heap = res.heap;
+	errors += res.errors;
+    }
+    else {
+	/* The worker died, most likely inside the malloc package */
+	st->valid = 0;
+	sprintf(msg, "%s malloc crashed (worker status 0x%x)", 
+		allocators[j / n].name, status);
+	malloc_error(j % n, 0, msg);
+    }
+    close(fds[j]);
+    pids[j] = 0;
+}
+
+/*
+ * eval_parallel - Check the correctness and utilization of each of the
+ *     npkgs first packages on each of the n traces, using up to njobs
+ *     worker processes at a time. Every (package, trace) pair is one 
+ *     job: a forked worker with its own copy of the simulated heap 
+ *     runs eval_mm_quality and sends the result back over a pipe. The
+ *     first CPU we may use is kept free of workers, and the driver 
+ *     pins itself to it for the timed runs that follow.
+ */
+static void eval_parallel(int njobs, int npkgs, int n, char **tracefiles, 
+			  stats_t **pkg_stats)
+{
+    int cpus[CPU_SETSIZE];
+    int ncpus, j, fd[2], running = 0, njob = npkgs * n;
+    pid_t *pids;
+    int *fds;
+    jobresult_t res;
+    stats_t st;
+    trace_t *trace;
+    range_t *ranges = NULL;
+
+    if ((pids = (pid_t *)calloc(njob, sizeof(pid_t))) == NULL ||
+	(fds = (int *)calloc(njob, sizeof(int))) == NULL)
+	unix_error("calloc failed in eval_parallel");
+    ncpus = list_cpus(cpus, CPU_SETSIZE);
+    if (verbose > 1)
+	printf("\nChecking %d jobs with %d workers\n", njob, njobs);
+
+    for (j = 0; j < njob; j++) {
+	if (running == njobs) {
+	    reap_worker(pids, fds, n, pkg_stats);
+	    running--;
+	}
+	if (pipe(fd) < 0)
+	    unix_error("pipe failed in eval_parallel");
+	fflush(stdout);
+	if ((pids[j] = fork()) < 0)
+	    unix_error("fork failed in eval_parallel");
+
+	if (pids[j] == 0) {
+	    /* Worker: evaluate package j/n on trace j%n */
+	    close(fd[0]);
+	    if (ncpus > 1)
+		pin_to_cpu(cpus[1 + j % (ncpus - 1)]);
+	    mm_pkg = &allocators[j / n];
+	    errors = 0;
+	    memset(&st, 0, sizeof(st));
+	    trace = read_trace(tracedir, tracefiles[j % n]);
+	    eval_mm_quality(trace, j % n, &ranges, &st);
+	    res.valid = st.valid;
+	    res.util = st.util;
+	    res.sbrks = st.sbrks;
+	    res.heap = st.heap;
+	    res.errors = errors;
+	    if (write(fd[1], &res, sizeof(res)) != sizeof(res))
+		unix_error("write failed in eval_parallel");
+	    fflush(stdout);
+	    _exit(0);
+	}
+	close(fd[1]);
+	fds[j] = fd[0];
+	running++;
+    }
+    while (running-- > 0)
+	reap_worker(pids, fds, n, pkg_stats);
+
+    if (cpus[0] >= 0)
+	pin_to_cpu(cpus[0]);
+    free(pids);
+    free(fds);
+}
+
+/**********************************************************************
+ * The following functions export the results in machine-readable form
+ * and compare them against a baseline saved by an earlier run.
+ **********************************************************************/
+
+/*
+ * writeresults1 - writes the records of one allocator to an export file
+ */
+static void writeresults1(FILE *fp, int json, int *first, char *alloc, 
+			  int n, char **tracefiles, stats_t *stats)
+{
+    int i;
+    double kops;
+
+    for (i=0; i < n; i++) {
+	kops = (stats[i].valid && stats[i].secs > 0) ? 
+	    (stats[i].ops/1e3)/stats[i].secs : 0.0;
+	if (json)
+	    fprintf(fp, "%s  {\"allocator\": \"%s\", \"trace\": %d, "
+		    "\"file\": \"%s\", \"valid\": %d, \"util\": %.6f, "
+		    "\"ops\": %.0f, \"secs\": %.9f, \"secs_sd\": %.9f, "
+		    "\"runs\": %d, \"kops\": %.1f, \"sbrks\": %d, "
+		    "\"heap\": %lu, \"secs_mad\": %.9f, \"secs_lo\": %.9f, "
+		    "\"secs_hi\": %.9f, \"secs_cold\": %.9f, "
+		    "\"util_avg\": %.6f}",
+		    *first ? "" : ",\n", alloc, i, tracefiles[i], 
+		    stats[i].valid, stats[i].util, stats[i].ops, stats[i].secs, 
+		    stats[i].secs_sd, stats[i].runs, kops, stats[i].sbrks, 
+		    (unsigned long)stats[i].heap, stats[i].secs_mad, 
+		    stats[i].secs_lo, stats[i].secs_hi, stats[i].secs_cold,
+		    stats[i].util_avg);
+	else
+	    fprintf(fp, "%s,%d,%s,%d,%.6f,%.0f,%.9f,%.9f,%d,%.1f,%d,%lu,"
+		    "%.9f,%.9f,%.9f,%.9f,%.6f\n",
+		    alloc, i, tracefiles[i], stats[i].valid, stats[i].util, 
+		    stats[i].ops, stats[i].secs, stats[i].secs_sd, 
+		    stats[i].runs, kops, stats[i].sbrks, 
+		    (unsigned long)stats[i].heap, stats[i].secs_mad, 
+		    stats[i].secs_lo, stats[i].secs_hi, stats[i].secs_cold,
+		    stats[i].util_avg);
+	*first = 0;
+    }
+}
+
+/*
+ * writeresults - exports the per-trace results of each allocator as 
+ *     JSON if path ends in ".json", and as CSV otherwise. JSON output 
+ *     holds one record per line, which is what read_baseline expects.
+ */
+static void writeresults(char *path, int n, char **tracefiles, 
+			 stats_t *libc_stats, stats_t **pkg_stats, int npkgs)
+{
+    FILE *fp;
+    int k, json, first = 1;
+
+    if ((fp = fopen(path, "w")) == NULL) {
+	sprintf(msg, "Could not open %s in writeresults", path);
+	unix_error(msg);
+    }
+    json = is_json(path);
+    if (json)
+	fprintf(fp, "[\n");
+    else
+	fprintf(fp, "allocator,trace,file,valid,util,ops,secs,secs_sd,runs,"
+		"kops,sbrks,heap,secs_mad,secs_lo,secs_hi,secs_cold,util_avg\n");
+    if (libc_stats)
+	writeresults1(fp, json, &first, "libc", n, tracefiles, libc_stats);
+    for (k=0; k < npkgs; k++)
+	writeresults1(fp, json, &first, allocators[k].name, n, tracefiles, 
+		      pkg_stats[k]);
+    if (json)
+	fprintf(fp, "\n]\n");
+    fclose(fp);
+}
+
+/*
+ * json_field - copies the value of "key" in a one-line JSON record
+ *     into val (without quotes). Returns 0 if the key is missing.
+ */
+static int json_field(char *line, char *key, char *val)
+{
+    char pat[MAXLINE];
+    char *p;
+    int len = 0;
+
+    sprintf(pat, "\"%s\":", key);
+    if ((p = strstr(line, pat)) == NULL)
+	return 0;
+    p += strlen(pat);
+    while (*p == ' ' || *p == '"')
+	p++;
+    while (*p && *p != '"' && *p != ',' && *p != '}' && len < MAXLINE-1)
+	val[len++] = *p++;
+    val[len] = '\0';
+    return 1;
+}
+
+/*
+ * csv_field - copies field number col of a CSV line into val
+ */
+static int csv_field(char *line, int col, char *val)
+{
+    int len = 0;
+
+    while (col > 0 && *line)
+	if (*line++ == ',')
+	    col--;
+    if (col > 0)
+	return 0;
+    while (*line && *line != ',' && *line != '\n' && len < MAXLINE-1)
+	val[len++] = *line++;
+    val[len] = '\0';
+    return 1;
+}
+
+/*
+ * read_baseline - reads a results file written by writeresults, in
+ *     either format, and returns an array of its *nrecs records
+ */
+static baseline_t *read_baseline(char *path, int *nrecs)
+{
+    /* columns of the CSV format, in the order writeresults emits them */
+    enum {C_ALLOC, C_TRACE, C_FILE, C_VALID, C_UTIL, C_OPS, C_SECS, 
+	  C_SECS_SD, C_RUNS, C_KOPS, C_SBRKS, C_HEAP, C_SECS_MAD, C_SECS_LO,
+	  C_SECS_HI};
+    static char *keys[] = {"allocator", "trace", "file", "valid", "util",
+			   "ops", "secs", "secs_sd", "runs", "kops", "sbrks",
+			   "heap", "secs_mad", "secs_lo", "secs_hi"};
+    FILE *fp;
+    char line[4*MAXLINE];
+    char vals[C_SECS_HI+1][MAXLINE];
+    baseline_t *recs = NULL;
+    int n = 0, cap = 0, json, j, ok;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+	sprintf(msg, "Could not open %s in read_baseline", path);
+	unix_error(msg);
+    }
+    json = is_json(path);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	ok = 1;
+	for (j = 0; j <= C_RUNS && ok; j++)
+	    ok = json ? json_field(line, keys[j], vals[j]) : 
+		csv_field(line, j, vals[j]);
+	if (!ok || !strcmp(vals[C_ALLOC], "allocator"))
+	    continue; /* not a record, e.g., the CSV header */
+	if (n == cap) {
+	    cap = cap ? 2*cap : 32;
+	    if ((recs = realloc(recs, cap * sizeof(baseline_t))) == NULL)
+		unix_error("realloc failed in read_baseline");
+	}
+	strcpy(recs[n].alloc, vals[C_ALLOC]);
+	strcpy(recs[n].file, vals[C_FILE]);
+	recs[n].valid = atoi(vals[C_VALID]);
+	recs[n].util = atof(vals[C_UTIL]);
+	recs[n].secs = atof(vals[C_SECS]);
+	recs[n].secs_sd = atof(vals[C_SECS_SD]);
+	recs[n].runs = atoi(vals[C_RUNS]);
+
+	/* Older baselines have no CI of the median */
+	recs[n].secs_lo = recs[n].secs_hi = 0.0;
+	if (json ? json_field(line, keys[C_SECS_LO], vals[C_SECS_LO]) &&
+	    json_field(line, keys[C_SECS_HI], vals[C_SECS_HI]) :
+	    csv_field(line, C_SECS_LO, vals[C_SECS_LO]) && 
+	    csv_field(line, C_SECS_HI, vals[C_SECS_HI])) {
+	    recs[n].secs_lo = atof(vals[C_SECS_LO]);
+	    recs[n].secs_hi = atof(vals[C_SECS_HI]);
+	}
+	n++;
+    }
+    fclose(fp);
+    *nrecs = n;
+    return recs;
+}
+
+/*
+ * median_se - standard error of a median running time, from its 95%
+ *     confidence interval (or, for old baselines, from the spread)
+ */
+static double median_se(double secs_lo, double secs_hi, double sd, int runs)
+{
+    if (secs_hi > secs_lo)
+	return (secs_hi - secs_lo) / (2 * 1.96);
+    return (runs > 0) ? sd / sqrt(runs) : 0.0;
+}
+
+/*
+ * compare_results - compares the results of one allocator against the
+ *     matching records of a saved baseline and prints the deltas. The
+ *     confidence interval of the throughput change comes from the
+ *     confidence intervals of the two median running times. Returns 
+ *     the number of significant regressions.
+ */
+static int compare_results(char *path, char *alloc, int n, 
+			   char **tracefiles, stats_t *stats)
+{
+    baseline_t *recs, *b;
+    int i, j, nrecs, bad, few, regressions = 0;
+    double sa, sb, se, dsecs, dthru, lo, hi, dutil;
+
+    recs = read_baseline(path, &nrecs);
+    printf("Comparison of %s malloc against %s:\n", alloc, path);
+    printf("%5s%7s%7s%7s%9s%9s%8s%19s\n", "trace", "util", "base",
+	   "delta", "Kops", "base", "delta", "95% CI     ");
+    for (i=0; i < n; i++) {
+	for (b = NULL, j = 0; j < nrecs && b == NULL; j++)
+	    if (!strcmp(recs[j].alloc, alloc) && 
+		!strcmp(recs[j].file, tracefiles[i]))
+		b = &recs[j];
+	if (b == NULL || !b->valid || !stats[i].valid) {
+	    printf("%2d%10s\n", i, b == NULL ? "(not in baseline)" : "-");
+	    continue;
+	}
+
+	/* Normal approximation of the difference of the median times */
+	sa = median_se(stats[i].secs_lo, stats[i].secs_hi, stats[i].secs_sd,
+		       stats[i].runs);
+	sb = median_se(b->secs_lo, b->secs_hi, b->secs_sd, b->runs);
+	se = sqrt(sa*sa + sb*sb);
+	dsecs = stats[i].secs - b->secs;
+
+	/* Express the change and its CI as a relative throughput change */
+	dthru = b->secs / stats[i].secs - 1.0;
+	lo = b->secs / (b->secs + dsecs + 1.96 * se) - 1.0;
+	hi = b->secs / fmax(b->secs + dsecs - 1.96 * se, DBL_MIN) - 1.0;
+	dutil = stats[i].util - b->util;
+
+	/*
+	 * With a single run on either side, the spread of the times is
+	 * unknown (se is 0), so a throughput drop can't be told from noise
+	 */
+	few = stats[i].runs < 2 || b->runs < 2;
+	bad = (strcmp(alloc, "libc") && dutil < -REGRESS_UTIL) ||
+	    (!few && dthru < -REGRESS_THRU && hi < 0);
+	regressions += bad;
+	printf("%2d%9.1f%%%6.1f%%%+6.1f%%%9.0f%9.0f%+7.1f%%  [%+6.1f%%,%+6.1f%%]%s\n",
+	       i, stats[i].util*100.0, b->util*100.0, dutil*100.0,
+	       (stats[i].ops/1e3)/stats[i].secs, (stats[i].ops/1e3)/b->secs, 
+	       dthru*100.0, lo*100.0, hi*100.0, bad ? "  REGRESSION" : 
+	       (few && dthru < -REGRESS_THRU) ? "  insufficient runs" : "");
+    }
+    printf("\n");
+    free(recs);
+    return regressions;
+}
+
+/*
+ * printevents - prints the hardware event counts per request of each 
+ *     trace, one column per available counter
+ */
+static void printevents(int n, stats_t *stats)
+{
+    int i, e;
+    double ops = 0, total[PC_NEVENTS] = {0};
+
+    printf("%5s", "trace");
+    for (e = 0; e < PC_NEVENTS; e++)
+	if (pc_available(e))
+	    printf("%11s", pc_names[e]);
+    printf("\n");
+    for (i=0; i < n; i++) {
+	printf("%2d   ", i);
+	if (!stats[i].valid) {
+	    printf("%11s\n", "-");
+	    continue;
+	}
+	ops += stats[i].ops;
+	for (e = 0; e < PC_NEVENTS; e++)
+	    if (pc_available(e)) {
+		printf("%11.2f", stats[i].events[e] / stats[i].ops);
+		total[e] += stats[i].events[e];
+	    }
+	printf("\n");
+    }
+    printf("Total");
+    for (e = 0; e < PC_NEVENTS; e++)
+	if (pc_available(e))
+	    printf("%11.2f", ops > 0 ? total[e] / ops : 0.0);
+    printf("\n");
+}
+
+/*
+ * printfaults - prints the page faults that each trace took per timed
+ *     run, in all and per thousand requests. With -z the heap is faulted
+ *     in up front, and what is left is mostly libc's and the driver's.
+ */
+static void printfaults(int n, stats_t *stats)
+{
+    int i;
+    double ops = 0, faults = 0;
+
+    printf("%5s%10s%9s\n", "trace", "faults", "per Kop");
+    for (i=0; i < n; i++) {
+	if (!stats[i].valid) {
+	    printf("%2d%13s\n", i, "-");
+	    continue;
+	}
+	printf("%2d%13.0f%9.2f\n", i, stats[i].faults, 
+	       stats[i].faults/(stats[i].ops/1e3));
+	ops += stats[i].ops;
+	faults += stats[i].faults;
+    }
+    if (ops > 0)
+	printf("Total%10.0f%9.2f\n", faults, faults/(ops/1e3));
+}
+
+/*
+ * printcold - prints the warm and cold cache throughput of each trace
+ *     side by side
+ */
+static void printcold(int n, stats_t *stats)
+{
+    int i;
+    double ops = 0, secs = 0, cold = 0;
+
+    printf("%5s%10s%10s%9s\n", "trace", "warm Kops", "cold Kops", "slowdown");
+    for (i=0; i < n; i++) {
+	if (!stats[i].valid) {
+	    printf("%2d%13s\n", i, "-");
+	    continue;
+	}
+	printf("%2d%13.0f%10.0f%8.2fx\n", i, (stats[i].ops/1e3)/stats[i].secs,
+	       (stats[i].ops/1e3)/stats[i].secs_cold, 
+	       stats[i].secs_cold/stats[i].secs);
+	ops += stats[i].ops;
+	secs += stats[i].secs;
+	cold += stats[i].secs_cold;
+    }
+    if (secs > 0 && cold > 0)
+	printf("Total%10.0f%10.0f%8.2fx\n", (ops/1e3)/secs, (ops/1e3)/cold,
+	       cold/secs);
+}
+
+/*
+ * printcaches - prints the cache hierarchy that -C evicts
+ */
+static void printcaches(void)
+{
+    cache_t caches[MAX_CACHES];
+    int i, n;
+
+    n = cache_levels(caches, MAX_CACHES);
+    printf("Caches:");
+    for (i = 0; i < n; i++)
+	printf(" L%d %s %luK (%dB lines)%s", caches[i].level, caches[i].type,
+	       (unsigned long)caches[i].size >> 10, caches[i].line,
+	       i < n-1 ? "," : "\n");
+    printf("Evicting them with a %lu KB sweep before each cold sample\n",
+	   (unsigned long)cache_evict_size() >> 10);
+}
+
+/*
+ * printmmstats - prints the internal stats of an allocator after a 
+ *     replay of one trace
+ */
+static void printmmstats(mm_stats_t *st)
+{
+    int i;
+
+    if (st->events) {
+	printf("  %lu mallocs, %lu frees, %lu reallocs (%lu in place)\n",
+	       st->mallocs, st->frees, st->reallocs, st->realloc_inplace);
+	printf("  %lu splits, %lu coalesces, %lu sbrks for %lu bytes\n",
+	       st->splits, st->coalesces, st->sbrk_calls, st->sbrk_bytes);
+	printf("  find_fit: %lu calls, %lu misses, %.1f blocks visited per "
+	       "call (max %lu)\n", st->fit_calls, st->fit_misses, 
+	       st->fit_calls ? (double)st->fit_walk / st->fit_calls : 0.0,
+	       st->fit_walk_max);
+    }
+    else
+	printf("  (event counters not compiled in; build mm.c with "
+	       "-DMM_STATS)\n");
+    printf("  %5s%9s%9s%9s%9s%11s\n", "class", "limit", "reqs", "hits",
+	   "free", "free bytes");
+    for (i = 0; i < st->nclasses; i++) {
+	if (st->class_limit[i])
+	    printf("  %5d%9lu", i, (unsigned long)st->class_limit[i]);
+	else
+	    printf("  %5d%9s", i, "-");
+	if (st->events)
+	    printf("%9lu%9lu", st->class_reqs[i], st->class_hits[i]);
+	else
+	    printf("%9s%9s", "-", "-");
+	printf("%9lu%11lu\n", st->class_free[i], st->class_bytes[i]);
+    }
+    printf("\n");
+}
+
+/*
+ * printregions - prints the throughput of the traces with region 
+ *     requests, replayed with per-object frees and with the region API.
+ *     Both replay the whole trace, even with -W.
+ */
+static void printregions(int n, stats_t *stats)
+{
+    int i;
+
+    printf("%5s%10s%12s%9s\n", "trace", "free Kops", "region Kops", 
+	   "speedup");
+    for (i=0; i < n; i++) {
+	if (!stats[i].valid || stats[i].secs_region == 0)
+	    continue;
+	printf("%2d%13.0f%12.0f%8.2fx\n", i, 
+	       (stats[i].ops_region/1e3)/stats[i].secs_free,
+	       (stats[i].ops_region/1e3)/stats[i].secs_region, 
+	       stats[i].secs_free/stats[i].secs_region);
+    }
+}
+
+/*
+ * printfootprint - prints the time averages of the footprint series 
+ *     next to the peak-based utilization. peak/avg is the peak heap 
+ *     over the average live payload: how much memory the trace holds
+ *     at its worst for each byte it uses on average.
+ */
+static void printfootprint(int n, stats_t *stats)
+{
+    int i;
+
+    printf("%5s%7s%9s%11s%11s%11s%9s\n", "trace", "util", "avg util",
+	   "peak heap", "peak live", "avg live", "peak/avg");
+    for (i=0; i < n; i++) {
+	if (!stats[i].valid) {
+	    printf("%2d%10s\n", i, "-");
+	    continue;
+	}
+	printf("%2d%9.0f%%%8.0f%%%11lu%11lu%11.0f%9.2f\n", i, 
+	       stats[i].util*100.0, stats[i].util_avg*100.0, 
+	       (unsigned long)stats[i].heap, (unsigned long)stats[i].peak_live,
+	       stats[i].live_avg, stats[i].live_avg > 0 ? 
+	       stats[i].heap / stats[i].live_avg : 0.0);
+    }
+}
+
+/*
+ * printmatrix - prints util and throughput of every evaluated package 
+ *     (and libc, if it ran) side by side, one row per trace
+ */
+static void printmatrix(int n, stats_t *libc_stats, stats_t **pkg_stats, 
+			int npkgs)
+{
+    int i, k;
+    stats_t *st;
+
+    printf("Comparison matrix (util%% and Kops):\n");
+    printf("%5s", "trace");
+    for (k=0; k < npkgs; k++)
+	printf("%15s", allocators[k].name);
+    if (libc_stats)
+	printf("%15s", "libc");
+    printf("\n");
+    for (i=0; i < n; i++) {
+	printf("%2d   ", i);
+	for (k=0; k <= npkgs; k++) {
+	    if (k == npkgs && !libc_stats)
+		break;
+	    st = (k < npkgs) ? &pkg_stats[k][i] : &libc_stats[i];
+	    if (!st->valid)
+		printf("%15s", "-");
+	    else if (k == npkgs)
+		printf("%7s%8.0f", "", (st->ops/1e3)/st->secs);
+	    else
+		printf("%6.0f%%%8.0f", st->util*100.0, (st->ops/1e3)/st->secs);
+	}
+	printf("\n");
+    }
+}
+
+/*
+ * printlatency - prints the per-request latency percentiles (in ns),
+ *     and those of all traces together for each request type
+ */
+static void printlatency(int n, lathist_t *hists) 
+{
+    int i, j, k;
+    double nspertick = 1e3 / counter_mhz();
+    lathist_t *h, total[NUM_OPTYPES];
+
+    for (j=0; j < NUM_OPTYPES; j++)
+	lh_init(&total[j]);
+    printf("%5s%9s%9s%9s%9s%9s%9s%10s\n", 
+	   "trace", "op", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (i=0; i <= n; i++) {
+	for (j=0; j < NUM_OPTYPES; j++) {
+	    h = (i < n) ? &hists[i * NUM_OPTYPES + j] : &total[j];
+	    if (h->count == 0)
+		continue;
+	    if (i < n) {
+		lh_merge(&total[j], h);
+		printf("%2d%12s%9llu", i, optype_names[j], h->count);
+	    }
+	    else
+		printf("%-5s%9s%9llu", "Total", optype_names[j], h->count);
+	    for (k=0; k < NUM_PCTS; k++)
+		printf("%9.0f", lh_percentile(h, lat_pcts[k]) * nspertick);
+	    printf("%10.0f\n", h->max * nspertick);
+	}
+    }
+}
+
+/*
+ * writelatency - exports the per-request latency percentiles (in ns) 
+ *     as JSON if path ends in ".json", and as CSV otherwise
+ */
+static void writelatency(char *path, int n, char **tracefiles, 
+			 lathist_t **pkg_lat, int npkgs)
+{
+    FILE *fp;
+    int i, k, a, json, first = 1;
+    double nspertick = 1e3 / counter_mhz();
+    lathist_t *h;
+
+    if ((fp = fopen(path, "w")) == NULL) {
+	sprintf(msg, "Could not open %s in writelatency", path);
+	unix_error(msg);
+    }
+    json = is_json(path);
+    if (json)
+	fprintf(fp, "[\n");
+    else
+	fprintf(fp, "allocator,trace,file,op,count,mean_ns,p50_ns,p90_ns,"
+		"p99_ns,p999_ns,max_ns\n");
+    for (a=0; a < npkgs; a++) {
+	for (i=0; i < n * NUM_OPTYPES; i++) {
+	    h = &pkg_lat[a][i];
+	    if (h->count == 0)
+		continue;
+	    if (json)
+		fprintf(fp, "%s  {\"allocator\": \"%s\", \"trace\": %d, "
+			"\"file\": \"%s\", \"op\": \"%s\", \"count\": %llu, "
+			"\"mean_ns\": %.1f", first ? "" : ",\n", 
+			allocators[a].name, i / NUM_OPTYPES, 
+			tracefiles[i / NUM_OPTYPES], optype_names[i % NUM_OPTYPES],
+			h->count, lh_mean(h) * nspertick);
+	    else
+		fprintf(fp, "%s,%d,%s,%s,%llu,%.1f", allocators[a].name, 
+			i / NUM_OPTYPES, tracefiles[i / NUM_OPTYPES], 
+			optype_names[i % NUM_OPTYPES], h->count, 
+			lh_mean(h) * nspertick);
+	    for (k=0; k < NUM_PCTS; k++) {
+		if (json)
+		    fprintf(fp, ", \"%s_ns\": %.0f", lat_pct_names[k], 
+			    lh_percentile(h, lat_pcts[k]) * nspertick);
+		else
+		    fprintf(fp, ",%.0f", 
+			    lh_percentile(h, lat_pcts[k]) * nspertick);
+	    }
+	    if (json)
+		fprintf(fp, ", \"max_ns\": %.0f}", h->max * nspertick);
+	    else
+		fprintf(fp, ",%.0f\n", h->max * nspertick);
+	    first = 0;
+	}
+    }
+    if (json)
+	fprintf(fp, "\n]\n");
+    fclose(fp);
+}
+
+/*
+ * is_json - true if an export file name asks for JSON rather than CSV
+ */
+static int is_json(char *path)
+{
+    size_t len = strlen(path);
+
+    return (len >= 5) && !strcmp(path + len - 5, ".json");
+}
+
 /* 
  * app_error - Report an arbitrary application error
  */
@@ -1004,14 +3408,40 @@ void malloc_error(int tracenum, int opnum, char *msg)
  */
 static void usage(void) 
 {
-    fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+    fprintf(stderr, "Usage: mdriver [-hvValpeCsMwLBXzH] [-f <file>] [-t <dir>] [-P <file>]\n");
+    fprintf(stderr, "               [-n <runs>] [-r <seed>] [-o <file>] [-b <file>]\n");
+    fprintf(stderr, "               [-j <n>] [-F <file>] [-i <n>] [-u <file>]\n");
+    fprintf(stderr, "               [-c <n>] [-W <lo>[:<hi>]]\n");
     fprintf(stderr, "Options\n");
     fprintf(stderr, "\t-a         Don't check the team structure.\n");
     fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
+    fprintf(stderr, "\t-F <file>  Analyze fragmentation, write heap maps to <file> (text or .pgm).\n");
     fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
     fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-H         Back the simulated heap with 2 MB huge pages.\n");
+    fprintf(stderr, "\t-i <n>     Sample the heap every <n> requests for -F and -u.\n");
+    fprintf(stderr, "\t-b <file>  Compare against baseline <file>, exit 2 on regressions.\n");
+    fprintf(stderr, "\t-c <n>     Run mm_check after each request, in full every <n>.\n");
+    fprintf(stderr, "\t-C         Time with cold caches as well as warm ones.\n");
+    fprintf(stderr, "\t-e         Count hardware events (instructions, cache misses, ...).\n");
+    fprintf(stderr, "\t-j <n>     Check correctness and utilization with <n> workers.\n");
     fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+    fprintf(stderr, "\t-L         Pass the lifetime of each block in the trace to mm_malloc_hint.\n");
+    fprintf(stderr, "\t-B         Replay runs of allocs and of frees with mm_malloc_batch and mm_free_batch.\n");
+    fprintf(stderr, "\t-M         Run every registered malloc package.\n");
+    fprintf(stderr, "\t-n <runs>  Time each trace at least <runs> times (default %d).\n",
+	    BENCH_MIN_SAMPLES);
+    fprintf(stderr, "\t-o <file>  Export the results to <file> (.json or CSV).\n");
+    fprintf(stderr, "\t-p         Print per-request latency percentiles.\n");
+    fprintf(stderr, "\t-P <file>  Also export them to <file> (.json or CSV).\n");
+    fprintf(stderr, "\t-s         Print the allocator's internal stats after each trace.\n");
+    fprintf(stderr, "\t-r <seed>  Time the traces in a random order.\n");
     fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+    fprintf(stderr, "\t-u <file>  Export the footprint over time to <file> (.json or CSV).\n");
     fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
     fprintf(stderr, "\t-V         Print additional debug info.\n");
+    fprintf(stderr, "\t-w         Validate with a shadow map of the heap (O(size) per request).\n");
+    fprintf(stderr, "\t-W <lo>[:<hi>] Time only requests <lo>%% to <hi>%% of each trace.\n");
+    fprintf(stderr, "\t-X         Time each run in a forked process, from the same state.\n");
+    fprintf(stderr, "\t-z         Fault in the whole simulated heap before timing.\n");
 }
@@ -18,26 +18,103 @@
 static char *mem_start_brk; /* points to first byte of heap */
 static char *mem_brk;       /* points to last byte of heap */
 static char *mem_max_addr;  /* largest legal heap address */
+static int mem_sbrk_calls;  /* successful mem_sbrk calls since last reset */
+static char *mem_map;       /* mapping that holds the heap (NULL: malloc'ed) */
+static size_t mem_map_size; /* its size */
+
+/* the heap saved by mem_snapshot */
+static char *snap_heap = NULL; /* copy of the heap bytes */
+static size_t snap_size = 0;   /* heap size at the snapshot */
+static size_t snap_alloc = 0;  /* bytes allocated for snap_heap */
+static int snap_sbrk_calls;    /* mem_sbrk_calls at the snapshot */
 
 /*
  * mem_init - initialize the memory system model
  */
 void mem_init(void) {
+    mem_init_flags(0);
+}
+
+/*
+ * map_heap - map the storage for the heap with mmap. With MEM_HUGEPAGES,
+ *    first try reserved huge pages (MAP_HUGETLB); if there are none, map
+ *    a region aligned to HUGE_PAGE and ask for transparent huge pages.
+ */
+static char *map_heap(int flags) {
+    int prot = PROT_READ | PROT_WRITE, mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *p;
+
+    if (flags & MEM_PREFAULT)
+        mflags |= MAP_POPULATE;
+#ifdef MAP_HUGETLB
+    if (flags & MEM_HUGEPAGES) {
+        mem_map_size = (MAX_HEAP + HUGE_PAGE - 1) & ~(size_t)(HUGE_PAGE - 1);
+        p = mmap(NULL, mem_map_size, prot, mflags | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            mem_map = p;
+            return p;
+        }
+        fprintf(stderr, "mem_init: no hugetlb pages (%s), trying transparent huge pages\n",
+                strerror(errno));
+    }
+#endif
+    mem_map_size = MAX_HEAP;
+    if (flags & MEM_HUGEPAGES)
+        mem_map_size += HUGE_PAGE; /* room to align the start */
+    /* populate only after madvise, or the pages would all be small */
+    if ((flags & MEM_HUGEPAGES) && (flags & MEM_PREFAULT))
+        mflags &= ~MAP_POPULATE;
+    if ((mem_map = mmap(NULL, mem_map_size, prot, mflags, -1, 0)) == MAP_FAILED) {
+        fprintf(stderr, "mem_init: mmap error: %s\n", strerror(errno));
+        exit(1);
+    }
+    p = mem_map;
+    if (flags & MEM_HUGEPAGES) {
+        p = (char *)(((size_t)p + HUGE_PAGE - 1) & ~(size_t)(HUGE_PAGE - 1));
+#ifdef MADV_HUGEPAGE
+        if (madvise(p, MAX_HEAP, MADV_HUGEPAGE) < 0)
+            fprintf(stderr, "mem_init: madvise error: %s\n", strerror(errno));
+#endif
+        if (flags & MEM_PREFAULT)
+            for (size_t off = 0; off < MAX_HEAP; off += mem_pagesize())
+                p[off] = 0;
+    }
+    return p;
+}
+
+/*
+ * mem_init_flags - initialize the memory system model. By default the
+ *    heap is malloc'ed and its pages are faulted in as the allocator
+ *    first touches them. MEM_PREFAULT faults them all in up front, and
+ *    MEM_HUGEPAGES backs the heap with HUGE_PAGE pages.
+ */
+void mem_init_flags(int flags) {
+    mem_map = NULL;
+    if (flags)
+        mem_start_brk = map_heap(flags);
     /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
+    else if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
         fprintf(stderr, "mem_init_vm: malloc error\n");
         exit(1);
     }
 
     mem_max_addr = mem_start_brk + MAX_HEAP; /* max legal heap address */
     mem_brk = mem_start_brk;                 /* heap is empty initially */
+    mem_sbrk_calls = 0;
 }
 
 /*
  * mem_deinit - free the storage used by the memory system model
  */
 void mem_deinit(void) {
-    free(mem_start_brk);
+    if (mem_map)
+        munmap(mem_map, mem_map_size);
+    else
+        free(mem_start_brk);
+    mem_map = NULL;
+    free(snap_heap);
+    snap_heap = NULL;
+    snap_size = snap_alloc = 0;
 }
 
 /*
@@ -45,6 +122,7 @@ void mem_deinit(void) {
  */
 void mem_reset_brk() {
     mem_brk = mem_start_brk;
+    mem_sbrk_calls = 0;
 }
 
 /*
@@ -61,9 +139,57 @@ void *mem_sbrk(int incr) {
         return (void *)-1;
     }
     mem_brk += incr;
+    mem_sbrk_calls++;
     return (void *)old_brk;
 }
 
+/*
+ * mem_snapshot - save a copy of the current heap and brk pointer. Only
+ *    the bytes below brk are copied; the rest of the modeled VM is
+ *    unused at the snapshot and needs no restoring.
+ */
+int mem_snapshot(void) {
+    size_t size = (size_t)(mem_brk - mem_start_brk);
+    char *p;
+
+    if (size > snap_alloc) {
+        if ((p = (char *)realloc(snap_heap, size)) == NULL)
+            return -1;
+        snap_heap = p;
+        snap_alloc = size;
+    }
+    memcpy(snap_heap, mem_start_brk, size);
+    snap_size = size;
+    snap_sbrk_calls = mem_sbrk_calls;
+    return 0;
+}
+
+/*
+ * mem_restore - copy the last snapshot back and reset brk to where it
+ *    was then. Whatever was written above the old brk since is left
+ *    behind as garbage, just like in a freshly extended heap.
+ */
+void mem_restore(void) {
+    memcpy(mem_start_brk, snap_heap, snap_size);
+    mem_brk = mem_start_brk + snap_size;
+    mem_sbrk_calls = snap_sbrk_calls;
+}
+
+/*
+ * mem_release - drop the pages of the modeled VM with MADV_DONTNEED.
+ *    In a forked child this also drops the pages it shares copy-on-write
+ *    with its parent. Only the whole pages inside the malloc'ed heap
+ *    are dropped; a mapped heap (MEM_PREFAULT, MEM_HUGEPAGES) is kept.
+ */
+void mem_release(void) {
+    size_t page = mem_pagesize();
+    char *lo = (char *)(((size_t)mem_start_brk + page - 1) & ~(page - 1));
+    char *hi = (char *)((size_t)mem_max_addr & ~(page - 1));
+
+    if (mem_map == NULL && hi > lo)
+        madvise(lo, hi - lo, MADV_DONTNEED);
+}
+
 /*
  * mem_heap_lo - return address of the first heap byte
  */
@@ -85,6 +211,14 @@ size_t mem_heapsize() {
     return (size_t)(mem_brk - mem_start_brk);
 }
 
+/*
+ * mem_sbrkcalls() - returns the number of successful mem_sbrk calls
+ *    since the heap was last reset
+ */
+int mem_sbrkcalls() {
+    return mem_sbrk_calls;
+}
+
 /*
  * mem_pagesize() - returns the page size of the system
  */
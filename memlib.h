@@ -1,11 +1,32 @@
 #include <unistd.h>
 
+#define MEM_PREFAULT  0x1      /* fault in the whole heap up front */
+#define MEM_HUGEPAGES 0x2      /* back the heap with huge pages */
+#define HUGE_PAGE (2 << 20)    /* huge page size (x86) */
+
 void mem_init(void);               
+void mem_init_flags(int flags);
 void mem_deinit(void);
 void *mem_sbrk(int incr);
 void mem_reset_brk(void); 
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+int mem_sbrkcalls(void);
 size_t mem_pagesize(void);
 
+/*
+ * mem_snapshot - Save a copy of the heap and the brk pointer, replacing
+ *     any earlier snapshot. Returns -1 if there is no memory for it.
+ * mem_restore - Put the heap back the way it was at the last snapshot
+ */
+int mem_snapshot(void);
+void mem_restore(void);
+
+/*
+ * mem_release - Give the heap's pages back to the kernel, so that the
+ *     next write to each takes a fresh zero-fill fault. The contents of
+ *     the heap are lost. Does nothing to a prefaulted or huge page heap.
+ */
+void mem_release(void);
+
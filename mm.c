@@ -1,5 +1,6 @@
 #include "mm.h"
 #include "memlib.h"
+#include "config.h"
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
@@ -22,6 +23,42 @@ team_t team = {
 #define DSIZE 8             // 더블워드의 크기
 #define CHUNKSIZE (1 << 12) // 초기 가용블록과 힙 확장을 위한 기본 크기 (4096 Byte)
 #define LISTLIMIT 12        // 클래스의 최대 개수
+#define MAXTOUCH 8          // mm_check 증분 모드가 기억하는 블록 수
+
+/*
+ * 수명 예측: 할당 SAMPLE_EVERY번에 한 번 블록을 표본으로 골라 태어난 시각(요청 수)을 기록하고,
+ * 해제될 때의 수명을 클래스별 평균에 반영. 평균 수명이 LONG_LIFE 이상인 클래스는 장수로 예측.
+ * 장수 블록은 가용블록의 뒤쪽 끝에 배치해서 앞쪽부터 채워지는 단명 블록과 섞이지 않게 함.
+ */
+#define SAMPLE_SLOTS 64 // 표본 슬롯 수 (블록 주소로 해시)
+#define SAMPLE_EVERY 8  // 표본 추출 간격 (할당 수)
+#define LONG_LIFE 2048  // 장수로 볼 평균 수명 (요청 수)
+#define MIN_SAMPLES 4   // 예측에 필요한 클래스별 최소 표본 수
+
+/*
+ * 디버그 모드 (-DMM_DEBUG): 할당블록의 footer 앞에 요청 크기와 체크섬 워드를 두고,
+ * 요청 크기 뒤의 남는 공간(redzone)을 패턴으로 채워서 mm_free 때 검사.
+ * 해제된 블록은 앞부분을 poison으로 채워 quarantine에 두고, 모인 크기가 힙의 1/QUARANTINE_DIV
+ * (최소 QUARANTINE_MIN 바이트)를 넘으면 오래된 블록부터 실제로 해제.
+ * -DMM_GUARD를 같이 주면 GUARD_MIN 이상의 블록 뒤에 mprotect guard page를 둠.
+ */
+#ifdef MM_DEBUG
+#define DEBUG_EXTRA DSIZE     // 요청 크기 워드 + 체크섬 워드
+#define CANARY 0x5ca1ab1e     // 체크섬 시드
+#define REDZONE 0xfd          // 요청 크기 뒤의 빈 공간
+#define POISON 0xdb           // 해제된 블록
+#define POISON_MAX 512        // 블록 앞쪽 최대 POISON_MAX 바이트만 poison (오버헤드 제한)
+#define QUARANTINE_DIV 16     // quarantine 한도 = 힙 크기 / QUARANTINE_DIV
+#define QUARANTINE_MIN CHUNKSIZE // 힙이 작을 때의 quarantine 한도 (바이트)
+#define QUARANTINE_MAX 1024   // quarantine 원형 버퍼 크기 (블록 수)
+#define GUARDED 0x80000000u   // 요청 크기 워드의 guard page 표시
+#define GUARD_MIN (1 << 15)   // guard page를 둘 최소 요청 크기
+#define MAXGUARDS 256         // 동시에 둘 수 있는 guard page 수
+#define DEBUG(stmt) (stmt)
+#else
+#define DEBUG_EXTRA 0
+#define DEBUG(stmt)
+#endif
 
 /*블록의 size와 alloc 여부 패킹*/
 #define PACK(size, alloc) ((size) | (alloc))
@@ -42,37 +79,138 @@ team_t team = {
 #define NEXT_BLKP(bp) ((char *)(bp) + GET_SIZE(HDRP(bp)))         // 다음 블록의 포인터 return
 #define PREV_BLKP(bp) ((char *)(bp) - GET_SIZE(HDRP(bp) - WSIZE)) // 이전 블록의 포인터 return
 
+/* 디버그 모드에서 할당블록 끝의 요청 크기/체크섬 워드 */
+#define REQ_SIZEP(bp) (FTRP(bp) - DSIZE)
+#define CHECKP(bp) (FTRP(bp) - WSIZE)
+#define CHECKSUM(bp) (CANARY ^ GET(HDRP(bp)) ^ GET(REQ_SIZEP(bp)) ^ (unsigned int)(size_t)(bp))
+
 /* 블록포인터(bp)의 다음 or 이전 가용블록 포인터 return */
 #define PRED_FREEP(bp) (*(void **)(bp))
 #define SUCC_FREEP(bp) (*(void **)(bp + WSIZE))
 
+/* 블록포인터(bp)의 표본 슬롯 */
+#define SLOT(bp) (((size_t)(bp) / DSIZE) % SAMPLE_SLOTS)
+
 /*클래스의 root*/
 #define GET_ROOT(class_n) (*(void **)((char *)(class_listp) + (WSIZE * class_n)))
 
 /*구현 함수*/
 static void *extend_heap(size_t words);    // 부족한 힙 공간을 확장
+static size_t adjust_size(size_t size);    // 요청 size를 실제 블록 크기로 변환
+static void free_block(void *bp);          // 가용블록으로 전환 후 병합
 static void *find_fit(size_t asize);       // 할당할 블록크기가 가용리스트에 있는지 탐색
-static void place(void *bp, size_t asize); // 할당할 블록의 크기와 맞는 블록이 있으면 (find_fit 진행 후) 배치
+static void *place(void *bp, size_t asize, int high); // 가용블록에 배치 (high면 뒤쪽 끝), 할당된 bp return
 static void *coalesce(void *bp);           // 가용블록들을 하나의 블록으로 병합
+#ifdef MM_STATS
+static void stat_walk(void); // find_fit 탐색 길이 누적
+#endif
 void putFreeBlock(void *bp);               // 가용리스트에 가용블록 삽입
 void removeBlock(void *bp);                // 가용리스트에서 할당된 블록 제거
 int get_class(size_t size);                // 요청한 size가 해당되는 클래스 인덱스
+#ifdef MM_CHECK
+static void touch(char *bp);               // 이번 요청에서 바뀐 블록 기록 (mm_check 증분 모드)
+static void touch_reset(void);             // 새 요청 시작, 기록 지우기
+#endif
+static int predict_long(size_t asize);     // asize 클래스가 장수로 예측되는지
+static void predict_alloc(char *bp, size_t asize); // 새 할당블록을 표본으로 기록
+static void predict_free(char *bp);        // 표본이 해제되면 수명 학습
+static void predict_learn(int class, long life);
+#ifdef MM_DEBUG
+static void debug_fail(void *bp, char *msg);   // 손상 보고 후 abort
+static void debug_reset(void);                  // guard page 해제, quarantine 비우기
+static void debug_arm(char *bp, size_t size);   // 새 할당블록에 redzone/체크섬/guard 설정
+static size_t debug_validate(char *bp);         // 할당블록 검사 후 요청 크기 return
+static void debug_unguard(char *bp, size_t size); // 블록의 guard page 해제
+static void debug_release(void);                // quarantine에서 가장 오래된 블록 해제
+static void debug_free(char *bp);               // poison 후 quarantine, 한도를 넘으면 오래된 블록 해제
+static void *debug_realloc(void *bp, size_t size);
+#endif
 
 /*전역 변수*/
 static char *heap_listp;         // 힙의 시작 포인트
 static char *class_listp = NULL; // 클래스리스트의 시작 포인트
 
+/*마지막 요청이 바꾼 블록들 (mm_check 증분 모드, -DMM_CHECK 일 때만 유지, 아니면 TOUCH()가 통째로 사라짐)*/
+#ifdef MM_CHECK
+static char *touched[MAXTOUCH];
+static int ntouched = 0;
+static int in_realloc = 0; // mm_realloc 안의 malloc/free는 기록을 지우지 않음
+#define TOUCH(stmt) (stmt)
+#else
+#define TOUCH(stmt)
+#endif
+
+/*수명 예측기 상태*/
+typedef struct {
+    char *bp;            // 표본 블록 (NULL: 빈 슬롯)
+    unsigned long birth; // 할당된 시각
+    int class;           // 할당 때의 클래스
+} sample_t;
+static sample_t samples[SAMPLE_SLOTS];
+static long life_avg[LISTLIMIT];          // 클래스별 평균 수명 (지수 이동평균)
+static unsigned long life_n[LISTLIMIT];   // 클래스별 학습한 표본 수
+static unsigned long now = 0;             // 지금까지의 malloc/free 요청 수 (시계)
+static int sample_skip = 0;               // 다음 표본까지 남은 할당 수
+
+/*full 모드에서 가용블록 위치를 표시하는 비트맵 (DSIZE당 1비트)*/
+static unsigned char free_map[MAX_HEAP / DSIZE / 8 + 1];
+
+/*디버그 모드 상태*/
+#ifdef MM_DEBUG
+typedef struct {
+    char *blk[QUARANTINE_MAX]; // 해제를 미룬 블록 (원형 버퍼, 오래된 순)
+    int head;                  // 가장 오래된 블록 위치
+    int count;                 // 들어 있는 블록 수
+    size_t bytes;              // 들어 있는 블록 크기의 합
+} quarantine_t;
+static quarantine_t quarantine;
+static char *guards[MAXGUARDS];      // mprotect된 guard page
+static int nguards = 0;
+#endif
+
+/*mm_snapshot이 저장한 전역 상태 (힙 내용은 memlib의 mem_snapshot이 저장)*/
+static struct {
+    char *heap_listp;
+    char *class_listp;
+    sample_t samples[SAMPLE_SLOTS];
+    long life_avg[LISTLIMIT];
+    unsigned long life_n[LISTLIMIT];
+    unsigned long now;
+    int sample_skip;
+#ifdef MM_DEBUG
+    quarantine_t quarantine;
+#endif
+#ifdef MM_STATS
+    mm_stats_t stats;
+#endif
+} snap;
+
+/*통계 카운터 (-DMM_STATS 일 때만 유지, 아니면 STAT()이 통째로 사라짐)*/
+#ifdef MM_STATS
+static mm_stats_t stats;      // 이벤트 카운터
+static unsigned long fit_cur; // 현재 find_fit 호출에서 방문한 가용블록 수
+#define STAT(stmt) (stmt)
+#else
+#define STAT(stmt)
+#endif
+
 /*----------------------------------------------mm_function()-----------------------------------------------------------*/
 
 /*
  * mm_init - 할당기 초기화
  */
 int mm_init(void) {
+    DEBUG(debug_reset()); // 이전 힙의 guard page부터 풀어야 재사용 가능
 
     // 메모리 시스템에서 segregated_list+4워드를 가져와서 초기화
     heap_listp = mem_sbrk((LISTLIMIT + 4) * WSIZE);
     if (heap_listp == (void *)-1)
         return -1;
+#ifdef MM_STATS
+    memset(&stats, 0, sizeof(stats)); // 새 힙이니 카운터 초기화
+#endif
+    STAT(stats.sbrk_calls++);
+    STAT(stats.sbrk_bytes += (LISTLIMIT + 4) * WSIZE);
 
     PUT(heap_listp, 0);                                              // 패딩
     PUT(heap_listp + (1 * WSIZE), PACK((LISTLIMIT + 2) * WSIZE, 1)); // 프롤로그 header
@@ -83,6 +221,14 @@ int mm_init(void) {
     PUT(heap_listp + ((LISTLIMIT + 3) * WSIZE), PACK(0, 1));                       // 에필로그 header
 
     class_listp = heap_listp + DSIZE; // 클래스 리스트의 시작 포인트
+    TOUCH(touch_reset());
+
+    // 새 힙이니 예측기도 처음부터 학습
+    memset(samples, 0, sizeof(samples));
+    memset(life_avg, 0, sizeof(life_avg));
+    memset(life_n, 0, sizeof(life_n));
+    now = 0;
+    sample_skip = 0;
 
     return 0;
 }
@@ -91,81 +237,251 @@ int mm_init(void) {
  * mm_malloc - 요청한 size만큼 메모리 할당.
  */
 void *mm_malloc(size_t size) {
-    size_t asize; // 실제 할당할 메모리 블록의 크기
+    return mm_malloc_hint(size, MM_HINT_NONE);
+}
+
+/*
+ * mm_malloc_hint - 수명 힌트와 함께 할당. 힌트가 없으면 클래스의 평균 수명으로 예측
+ */
+void *mm_malloc_hint(size_t size, int hint) {
+    size_t asize;  // 실제 할당할 메모리 블록의 크기
+    int long_life; // 장수 블록이면 가용블록의 뒤쪽 끝에 배치
     void *bp;
 
+    STAT(stats.mallocs++);
+    TOUCH(touch_reset());
     if (size == 0)
         return NULL;
-
-    // 요청 size가 블록 최소크기(4워드) 보다 작거나 같으면
-    if (size <= DSIZE)
-        asize = 2 * DSIZE; // 4워드 할당(16 byte)
-    else
-        asize = DSIZE * ((size + (DSIZE) + (DSIZE - 1)) / DSIZE); // 오버헤드 바이트 추가 후 인접 8의 배수로 반올림
+    asize = adjust_size(size);
+    now++;
+    long_life = (hint == MM_HINT_NONE) ? predict_long(asize) : (hint == MM_HINT_LONG);
 
     // 요청된 size에 맞는 가용블록 찾기
     bp = find_fit(asize);
-    // 가용블록이 있을 경우
-    if (bp != NULL) {
-        place(bp, asize);
-        return bp;
+    // 가용블럭이 없을 경우
+    if (bp == NULL) {
+        // 장수 블록은 CHUNKSIZE만큼 늘려서, 남는 앞쪽을 단명 블록이 쓰게 함
+        if (long_life && asize < CHUNKSIZE)
+            bp = extend_heap(CHUNKSIZE / WSIZE);
+        else
+            bp = extend_heap(asize / WSIZE); // 요청한 size만큼 메모리 할당
+        if (bp == NULL)
+            return NULL;
     }
+    bp = place(bp, asize, long_life);
+    predict_alloc(bp, asize);
+    DEBUG(debug_arm(bp, size));
+    return bp;
+}
 
-    // 가용블럭이 없을 경우
-    bp = extend_heap(asize / WSIZE); // 요청한 size만큼 메모리 할당
-    if (bp != NULL) {
-        place(bp, asize);
-        return bp;
-    } else {
-        return NULL;
+/*
+ * mm_malloc_batch - 같은 크기 size의 블록 n개를 가용블록 하나에서 연속으로 잘라 ptrs에 저장.
+ *     find_fit/분할은 한 번만. 할당한 블록 수(n 또는 0) return
+ */
+int mm_malloc_batch(size_t size, int n, void **ptrs) {
+    size_t asize, total, bsize, this;
+    char *bp;
+
+    TOUCH(touch_reset());
+    if (size == 0 || n <= 0)
+        return 0;
+    now += n;
+    asize = adjust_size(size);
+    total = asize * n;
+
+    // n개를 한 번에 담을 가용블록 찾기, 없으면 힙 확장
+    if ((bp = find_fit(total)) == NULL && (bp = extend_heap(total / WSIZE)) == NULL)
+        return 0;
+    STAT(stats.mallocs += n);
+    removeBlock(bp);
+    bsize = GET_SIZE(HDRP(bp));
+
+    for (int i = 0; i < n; i++) {
+        this = asize;
+        if (i == n - 1 && bsize - total < 2 * DSIZE)
+            this += bsize - total; // 분할할 수 없는 나머지는 마지막 블록에 포함
+        PUT(HDRP(bp), PACK(this, 1));
+        PUT(FTRP(bp), PACK(this, 1));
+        DEBUG(debug_arm(bp, size));
+        TOUCH(touch(bp));
+        ptrs[i] = bp;
+        bp = NEXT_BLKP(bp);
+    }
+    // 남은 부분은 가용블록 하나로
+    if (bsize - total >= 2 * DSIZE) {
+        STAT(stats.splits++);
+        PUT(HDRP(bp), PACK(bsize - total, 0));
+        PUT(FTRP(bp), PACK(bsize - total, 0));
+        putFreeBlock(bp);
+        TOUCH(touch(bp));
     }
+    return n;
 }
 
 /*
  * mm_free - 가용블록으로 전환
  */
 void mm_free(void *bp) {
-    size_t size = GET_SIZE(HDRP(bp));
-
-    PUT(HDRP(bp), PACK(size, 0)); // 가용블록으로 전환(header 정보 수정=>0)
-    PUT(FTRP(bp), PACK(size, 0)); // 가용블록으로 전환(footer 정보 수정=>0)
-    coalesce(bp);                 // 인접 블록이 가용블록이면 병합
+    STAT(stats.frees++);
+    TOUCH(touch_reset());
+    now++;
+    predict_free(bp); // 블록의 수명은 사용자가 해제한 시점에 끝남
+#ifdef MM_DEBUG
+    debug_free(bp); // quarantine을 거쳐서 나중에 free_block
+#else
+    free_block(bp);
+#endif
 }
 
 /*
  * mm_realloc -메모리 블록의 크기를 조정하는 데 사용
  */
 void *mm_realloc(void *bp, size_t size) {
+    STAT(stats.reallocs++);
+    TOUCH(touch_reset());
     if (size <= 0) {
         mm_free(bp);
         return 0;
     }
     if (bp == NULL)
         return mm_malloc(size);
+#ifdef MM_DEBUG
+    return debug_realloc(bp, size);
+#endif
 
     size_t old_size = GET_SIZE(HDRP(bp));
     size_t next_size = GET_SIZE(HDRP(NEXT_BLKP(bp)));
     size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
 
-    if (size + 2 * WSIZE <= old_size)
+    if (size + 2 * WSIZE <= old_size) {
+        STAT(stats.realloc_inplace++);
+        TOUCH(touch(bp));
         return bp;
+    }
     if (!next_alloc && size + 2 * WSIZE <= old_size + next_size) {
         removeBlock(NEXT_BLKP(bp));
         PUT(HDRP(bp), PACK(old_size + next_size, 1));
         PUT(FTRP(bp), PACK(old_size + next_size, 1));
+        STAT(stats.realloc_inplace++);
+        TOUCH(touch(bp));
         return bp;
     }
 
+    TOUCH(in_realloc = 1);
     void *newp = mm_malloc(size);
-    if (newp == NULL)
+    if (newp == NULL) {
+        TOUCH(in_realloc = 0);
         return 0;
+    }
     memcpy(newp, bp, old_size);
     mm_free(bp);
+    TOUCH(in_realloc = 0);
     return newp;
 }
 
+/*
+ * cmp_addr - qsort용 주소 비교
+ */
+static int cmp_addr(const void *a, const void *b) {
+    char *p = *(char **)a, *q = *(char **)b;
+    return (p > q) - (p < q);
+}
+
+/*
+ * mm_free_batch - ptrs의 블록 n개를 해제. 주소 순으로 정렬한 뒤 (ptrs의 순서가 바뀜)
+ *     바로 붙어 있는 블록들은 하나로 합쳐서 병합/가용리스트 삽입을 한 번만 함
+ */
+void mm_free_batch(void **ptrs, int n) {
+    size_t size;
+    char *bp;
+    int i, j;
+
+    qsort(ptrs, n, sizeof(void *), cmp_addr);
+#ifdef MM_DEBUG
+    for (i = 0; i < n; i++) // 블록마다 검사하고 quarantine을 거쳐야 함
+        if (ptrs[i] != NULL)
+            mm_free(ptrs[i]);
+    return;
+#endif
+    TOUCH(touch_reset());
+    for (i = 0; i < n && ptrs[i] == NULL; i++) // NULL은 정렬하면 맨 앞
+        ;
+    while (i < n) {
+        bp = ptrs[i];
+        size = GET_SIZE(HDRP(bp));
+        predict_free(bp);
+        for (j = i + 1; j < n && (char *)ptrs[j] == bp + size; j++) {
+            size += GET_SIZE(HDRP(ptrs[j])); // 주소가 이어지는 블록들을 하나로
+            predict_free(ptrs[j]);
+        }
+        now += j - i;
+        STAT(stats.frees += j - i);
+        PUT(HDRP(bp), PACK(size, 0));
+        PUT(FTRP(bp), PACK(size, 0));
+        coalesce(bp);
+        i = j;
+    }
+}
+
+/*
+ * mm_free_sized - 호출자가 아는 요청 크기와 함께 해제.
+ *     병합에 블록 크기(경계 태그)가 어차피 필요해서 header는 읽고, 대신 크기 불일치를 잡음
+ */
+void mm_free_sized(void *bp, size_t size) {
+    if (bp == NULL)
+        return;
+#ifdef MM_DEBUG
+    if (debug_validate(bp) != size)
+        debug_fail(bp, "mm_free_sized: size differs from the requested size");
+#else
+    assert(size <= mm_usable_size(bp));
+#endif
+    mm_free(bp);
+}
+
+/*
+ * mm_usable_size - 블록에서 실제로 쓸 수 있는 바이트 수 (분할 안 된 나머지 포함)
+ */
+size_t mm_usable_size(void *bp) {
+    if (bp == NULL)
+        return 0;
+#ifdef MM_DEBUG
+    return debug_validate(bp); // 나머지는 redzone
+#else
+    return GET_SIZE(HDRP(bp)) - DSIZE; // header + footer 제외
+#endif
+}
+
 /*----------------------------------------------add_function()-----------------------------------------------------------*/
 
+/*
+ * free_block - 할당블록 bp를 가용블록으로 전환하고 병합
+ */
+static void free_block(void *bp) {
+    size_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, 0)); // 가용블록으로 전환(header 정보 수정=>0)
+    PUT(FTRP(bp), PACK(size, 0)); // 가용블록으로 전환(footer 정보 수정=>0)
+    coalesce(bp);                 // 인접 블록이 가용블록이면 병합
+}
+
+/*
+ * adjust_size - 요청 size를 실제 블록 크기(오버헤드 포함, 8의 배수, 최소 4워드)로 변환
+ */
+static size_t adjust_size(size_t size) {
+#ifdef MM_DEBUG
+#ifdef MM_GUARD
+    if (size >= GUARD_MIN)
+        size += 2 * mem_pagesize(); // 페이지 정렬 여유 + guard page
+#endif
+    size += DEBUG_EXTRA;
+#endif
+    // 요청 size가 블록 최소크기(4워드) 보다 작거나 같으면
+    if (size <= DSIZE)
+        return 2 * DSIZE; // 4워드 할당(16 byte)
+    return DSIZE * ((size + (DSIZE) + (DSIZE - 1)) / DSIZE); // 오버헤드 바이트 추가 후 인접 8의 배수로 반올림
+}
+
 /*
  * extend_heap - 부족한 힙 공간을 확장
  */
@@ -180,6 +496,8 @@ static void *extend_heap(size_t words) {
     // 공간할당 실패시 NULL return
     if (bp == (void *)-1)
         return NULL;
+    STAT(stats.sbrk_calls++);
+    STAT(stats.sbrk_bytes += size);
 
     PUT(HDRP(bp), PACK(size, 0));         // 새 가용블록의 header
     PUT(FTRP(bp), PACK(size, 0));         // 새 가용블록의 footer
@@ -196,38 +514,74 @@ static void *find_fit(size_t asize) {
     int class_idx; // 요청된 size가 segregated_list의 어떤 class에 할당할지 찾기
     void *bp;
 
+    STAT(stats.fit_calls++);
+    STAT(stats.class_reqs[get_class(asize)]++);
+    STAT(fit_cur = 0);
     for (class_idx = get_class(asize); class_idx < LISTLIMIT; class_idx++) {
         for (bp = GET_ROOT(class_idx); bp != NULL; bp = SUCC_FREEP(bp)) {
+            STAT(fit_cur++);
             if (GET_SIZE(HDRP(bp)) >= asize) {
+                STAT(stats.class_hits[class_idx]++);
+                STAT(stat_walk());
                 return bp;
             }
         }
     }
+    STAT(stats.fit_misses++);
+    STAT(stat_walk());
     return NULL;
 }
 
+#ifdef MM_STATS
 /*
- * place - 요청한 size를 할당할 수 있는 블록에 배치
+ * stat_walk - find_fit 한 번의 탐색 길이를 누적
  */
-static void place(void *bp, size_t asize) {
+static void stat_walk(void) {
+    stats.fit_walk += fit_cur;
+    if (fit_cur > stats.fit_walk_max)
+        stats.fit_walk_max = fit_cur;
+}
+#endif
+
+/*
+ * place - 요청한 size를 할당할 수 있는 블록에 배치. high(장수 블록)면 가용블록의 뒤쪽 끝에 배치
+ */
+static void *place(void *bp, size_t asize, int high) {
     size_t bsize = GET_SIZE(HDRP(bp)); // 가용 블록의 크기
+    void *newp = bp;                   // 할당된 블록
 
     removeBlock(bp); // 할당될 블록이니 가용리스트 내부에서 제거
 
-    if ((bsize - asize) >= (2 * DSIZE)) {
+    if ((bsize - asize) >= (2 * DSIZE) && high) {
+        STAT(stats.splits++);
+        // 앞쪽을 가용블록으로 남기고 뒤쪽 끝에 할당 (장수 블록)
+        PUT(HDRP(bp), PACK(bsize - asize, 0));
+        PUT(FTRP(bp), PACK(bsize - asize, 0));
+        putFreeBlock(bp);
+        TOUCH(touch(bp));
+        newp = NEXT_BLKP(bp);
+        PUT(HDRP(newp), PACK(asize, 1));
+        PUT(FTRP(newp), PACK(asize, 1));
+        TOUCH(touch(newp));
+    } else if ((bsize - asize) >= (2 * DSIZE)) {
+        STAT(stats.splits++);
         // 가용 블록을 분할하여 요청된 크기의 메모리 블록을 할당하고 남은 부분을 가용 블록으로 설정합니다.
         PUT(HDRP(bp), PACK(asize, 1));         // 할당된 블록의 header 설정
         PUT(FTRP(bp), PACK(asize, 1));         // 할당된 블록의 footer 설정
+        TOUCH(touch(bp));
         bp = NEXT_BLKP(bp);                    // 다음 블록 이동
         PUT(HDRP(bp), PACK(bsize - asize, 0)); // 남은 가용 블록의 header 설정
         PUT(FTRP(bp), PACK(bsize - asize, 0)); // 남은 가용 블록의 footer 설정
+        TOUCH(touch(bp));
 
         putFreeBlock(bp); // 가용리스트 첫번째에 분할된 새로운 가용블록 삽입
     } else {
         // 가용 블록을 분할할 만큼의 공간이 없는 경우
         PUT(HDRP(bp), PACK(bsize, 1)); // 가용 블록 전체를 할당된 블록으로 설정
         PUT(FTRP(bp), PACK(bsize, 1)); // 가용 블록 전체를 할당된 블록으로 설정
+        TOUCH(touch(bp));
     }
+    return newp;
 }
 
 /*
@@ -240,6 +594,7 @@ static void *coalesce(void *bp) {
 
     // case1 : 이전 블록은 할당되어 있고 다음 블록은 가용 상태인 경우
     if (prev_alloc && !next_alloc) {
+        STAT(stats.coalesces++);
         removeBlock(NEXT_BLKP(bp));              // 일단 다음 블록 삭제
         size += GET_SIZE(HDRP(NEXT_BLKP(bp)));   // 현재 블록의 크기 증가(+다음블록의 header size)
         PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0)); // 다음 bp 기준으로 footer 가용블록 설정
@@ -248,6 +603,7 @@ static void *coalesce(void *bp) {
     }
     // case2 : 이전 블록은 가용 상태이고 다음 블록은 할당되어 있는 경우
     else if (!prev_alloc && next_alloc) {
+        STAT(stats.coalesces++);
         removeBlock(PREV_BLKP(bp));            // 일단 이전 블록 삭제
         size += GET_SIZE(HDRP(PREV_BLKP(bp))); // 현재 블록의 크기 증가(+이전블록의 header size)
         PUT(FTRP(bp), PACK(size, 0));          // 현재 bp 기준으로 footer 가용블록 설정
@@ -257,6 +613,7 @@ static void *coalesce(void *bp) {
     }
     // case3 : 이전 블록과 다음 블록이 모두 가용 상태인 경우
     else if (!prev_alloc && !next_alloc) {
+        STAT(stats.coalesces += 2);
         removeBlock(PREV_BLKP(bp));                                            // 일단 이전 블록 삭제
         removeBlock(NEXT_BLKP(bp));                                            // 일단 다음 블록 삭제
         size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(FTRP(NEXT_BLKP(bp))); // 현재 블록의 크기 증가(+이전블록의 header size,다음블록의 header size)
@@ -266,6 +623,7 @@ static void *coalesce(void *bp) {
     }
 
     putFreeBlock(bp); // 병합 후 가용블록을 가용리스트에 삽입
+    TOUCH(touch(bp));
     return bp;
 }
 
@@ -288,6 +646,8 @@ void removeBlock(void *bp) {
     int class_idx = get_class(GET_SIZE(HDRP(bp)));
     if (bp == GET_ROOT(class_idx)) {          // 삭제할 블록이 해당 클래스의 root일 경우
         GET_ROOT(class_idx) = SUCC_FREEP(bp); // 삭제할 블록의 이전을 root로 설정
+        if (SUCC_FREEP(bp) != NULL)
+            PRED_FREEP(SUCC_FREEP(bp)) = NULL; // 새 root의 pred가 지워진 블록을 가리키지 않게
     } else {
         SUCC_FREEP(PRED_FREEP(bp)) = SUCC_FREEP(bp); // 삭제할 블록의 앞블록과 이전블록을 연결
         if (SUCC_FREEP(bp) != NULL)
@@ -307,3 +667,495 @@ int get_class(size_t size) {
     }
     return LISTLIMIT - 1;
 }
+
+#ifdef MM_CHECK
+/*
+ * touch - 이번 요청에서 바뀐 블록 bp를 기록. 병합/배치로 bp 안에 묻힌 이전 기록은 지움
+ */
+static void touch(char *bp) {
+    char *end = bp + GET_SIZE(HDRP(bp));
+    int i, n = 0;
+
+    for (i = 0; i < ntouched; i++)
+        if (touched[i] < bp || touched[i] >= end)
+            touched[n++] = touched[i];
+    ntouched = n;
+    if (ntouched < MAXTOUCH)
+        touched[ntouched++] = bp;
+}
+
+/*
+ * touch_reset - 새 요청이 시작되면 기록을 지움. mm_realloc 안의 malloc/free는 같은 요청
+ */
+static void touch_reset(void) {
+    if (!in_realloc)
+        ntouched = 0;
+}
+#endif
+
+/*
+ * predict_long - asize 클래스의 블록이 오래 살 것으로 예측되면 1
+ */
+static int predict_long(size_t asize) {
+    int class = get_class(asize);
+
+    return life_n[class] >= MIN_SAMPLES && life_avg[class] >= LONG_LIFE;
+}
+
+/*
+ * predict_alloc - SAMPLE_EVERY번째 할당마다 bp를 표본으로 기록.
+ * 슬롯의 이전 표본이 LONG_LIFE 넘게 살아 있으면 지금까지의 수명으로 학습하고 교체
+ * (해제되지 않는 블록도 장수로 학습되도록)
+ */
+static void predict_alloc(char *bp, size_t asize) {
+    int slot = SLOT(bp);
+
+    if (--sample_skip > 0)
+        return;
+    sample_skip = SAMPLE_EVERY;
+    if (samples[slot].bp != NULL) {
+        if (now - samples[slot].birth < LONG_LIFE)
+            return; // 아직 젊은 표본은 그대로 둠
+        predict_learn(samples[slot].class, now - samples[slot].birth);
+    }
+    samples[slot].bp = bp;
+    samples[slot].birth = now;
+    samples[slot].class = get_class(asize);
+}
+
+/*
+ * predict_free - 해제되는 bp가 표본이면 수명을 학습하고 슬롯을 비움
+ */
+static void predict_free(char *bp) {
+    int slot = SLOT(bp);
+
+    if (samples[slot].bp == bp) {
+        predict_learn(samples[slot].class, now - samples[slot].birth);
+        samples[slot].bp = NULL;
+    }
+}
+
+/*
+ * predict_learn - 클래스의 평균 수명에 표본 하나 반영 (가중치 1/8의 지수 이동평균)
+ */
+static void predict_learn(int class, long life) {
+    if (life_n[class]++ == 0)
+        life_avg[class] = life;
+    else
+        life_avg[class] += (life - life_avg[class]) / 8;
+}
+
+/*----------------------------------------------debug()-----------------------------------------------------------*/
+
+#ifdef MM_DEBUG
+/*
+ * debug_fail - 손상을 발견하면 바로 중단 (core dump를 남기도록 abort)
+ */
+static void debug_fail(void *bp, char *msg) {
+    fprintf(stderr, "mm: block %p: %s\n", bp, msg);
+    abort();
+}
+
+/*
+ * guard_page - 요청 크기 size인 블록 bp의 guard page 주소 (payload 끝 다음 페이지 경계)
+ */
+static char *guard_page(char *bp, size_t size) {
+    size_t page = mem_pagesize();
+    return (char *)(((size_t)bp + size + page - 1) & ~(page - 1));
+}
+
+/*
+ * debug_reset - 이전 힙의 guard page를 모두 풀고 quarantine 비우기
+ */
+static void debug_reset(void) {
+    for (int i = 0; i < nguards; i++)
+        mprotect(guards[i], mem_pagesize(), PROT_READ | PROT_WRITE);
+    nguards = 0;
+    memset(&quarantine, 0, sizeof(quarantine));
+}
+
+/*
+ * debug_arm - 새 할당블록 bp(요청 크기 size)의 redzone, 요청 크기, 체크섬 설정
+ */
+static void debug_arm(char *bp, size_t size) {
+    char *end = REQ_SIZEP(bp); // redzone의 끝
+    unsigned int flag = 0;
+
+#ifdef MM_GUARD
+    char *guard = guard_page(bp, size);
+    if (size >= GUARD_MIN && nguards < MAXGUARDS && guard + mem_pagesize() <= end &&
+        mprotect(guard, mem_pagesize(), PROT_NONE) == 0) {
+        guards[nguards++] = guard;
+        flag = GUARDED;
+        end = guard; // guard page 뒤는 건드리지 않음
+    }
+#endif
+    memset(bp + size, REDZONE, end - (bp + size));
+    PUT(REQ_SIZEP(bp), size | flag);
+    PUT(CHECKP(bp), CHECKSUM(bp));
+}
+
+/*
+ * debug_validate - 할당블록 bp의 경계 태그, 체크섬, redzone 검사 후 요청 크기 return
+ */
+static size_t debug_validate(char *bp) {
+    char *lo = mem_heap_lo(), *hi = mem_heap_hi(), *end;
+    size_t size;
+
+    if (bp < lo || bp > hi || (size_t)(bp - lo) % DSIZE != 0)
+        debug_fail(bp, "pointer was not returned by mm_malloc");
+    if (!GET_ALLOC(HDRP(bp)))
+        debug_fail(bp, "block is not allocated (double free?)");
+    if (GET_SIZE(HDRP(bp)) < 2 * DSIZE || FTRP(bp) > hi - WSIZE + 1)
+        debug_fail(bp, "header is damaged");
+    if (GET(HDRP(bp)) != GET(FTRP(bp)))
+        debug_fail(bp, "header and footer differ");
+    if (GET(CHECKP(bp)) != CHECKSUM(bp))
+        debug_fail(bp, "bad checksum: header damaged, or block already freed");
+    size = GET(REQ_SIZEP(bp)) & ~GUARDED;
+    end = (GET(REQ_SIZEP(bp)) & GUARDED) ? guard_page(bp, size) : REQ_SIZEP(bp);
+    for (char *p = bp + size; p < end; p++)
+        if (*(unsigned char *)p != REDZONE)
+            debug_fail(bp, "write past the end of the block");
+    return size;
+}
+
+/*
+ * debug_unguard - 요청 크기 size인 블록 bp에 guard page가 걸려 있으면 해제
+ */
+static void debug_unguard(char *bp, size_t size) {
+    char *guard;
+
+    if (!(GET(REQ_SIZEP(bp)) & GUARDED))
+        return;
+    guard = guard_page(bp, size);
+    mprotect(guard, mem_pagesize(), PROT_READ | PROT_WRITE);
+    for (int i = 0; i < nguards; i++)
+        if (guards[i] == guard) {
+            guards[i] = guards[--nguards];
+            break;
+        }
+}
+
+/*
+ * debug_release - quarantine에서 가장 오래된 블록을 꺼내 poison이 그대로인지 확인 후 해제
+ */
+static void debug_release(void) {
+    char *bp = quarantine.blk[quarantine.head];
+    size_t n = REQ_SIZEP(bp) - bp;
+
+    quarantine.head = (quarantine.head + 1) % QUARANTINE_MAX;
+    quarantine.count--;
+    quarantine.bytes -= GET_SIZE(HDRP(bp));
+    for (char *p = bp; p < bp + (n < POISON_MAX ? n : POISON_MAX); p++)
+        if (*(unsigned char *)p != POISON)
+            debug_fail(bp, "write after free");
+    free_block(bp);
+}
+
+/*
+ * debug_free - 블록 bp를 검사하고 poison해서 quarantine에 넣음.
+ *     quarantine에 모인 크기가 한도를 넘으면 오래된 블록부터 해제
+ */
+static void debug_free(char *bp) {
+    size_t size = debug_validate(bp), n, limit;
+
+    debug_unguard(bp, size);
+    n = REQ_SIZEP(bp) - bp;
+    memset(bp, POISON, n < POISON_MAX ? n : POISON_MAX);
+    PUT(CHECKP(bp), ~CHECKSUM(bp)); // 다시 free하면 체크섬 불일치
+
+    if (quarantine.count == QUARANTINE_MAX) // 버퍼가 가득 차면 자리부터 비움
+        debug_release();
+    quarantine.blk[(quarantine.head + quarantine.count++) % QUARANTINE_MAX] = bp;
+    quarantine.bytes += GET_SIZE(HDRP(bp));
+    if ((limit = mem_heapsize() / QUARANTINE_DIV) < QUARANTINE_MIN)
+        limit = QUARANTINE_MIN;
+    while (quarantine.bytes > limit)
+        debug_release();
+}
+
+/*
+ * debug_realloc - 디버그 모드의 realloc: 블록 안에 들어가거나 다음 블록이 가용(또는 힙의 끝)이면
+ *     그 자리에서 크기를 바꾸고 redzone/체크섬/guard를 새 크기로 다시 설정, 아니면 새 블록으로 옮김
+ */
+static void *debug_realloc(void *bp, size_t size) {
+    size_t old_size = debug_validate(bp);
+    size_t asize = adjust_size(size), bsize = GET_SIZE(HDRP(bp));
+    char *next = NEXT_BLKP(bp);
+    void *newp;
+
+    if (asize > bsize && GET_SIZE(HDRP(next)) == 0) // 힙의 끝이면 모자란 만큼만 확장 (최소 4워드)
+        extend_heap((asize - bsize < 2 * DSIZE ? 2 * DSIZE : asize - bsize) / WSIZE);
+    if (asize <= bsize || (!GET_ALLOC(HDRP(next)) && asize <= bsize + GET_SIZE(HDRP(next)))) {
+        debug_unguard(bp, old_size); // REQ_SIZEP가 바뀌기 전에 풀어야 함
+        if (asize > bsize) {
+            removeBlock(next);
+            bsize += GET_SIZE(HDRP(next));
+            PUT(HDRP(bp), PACK(bsize, 1));
+            PUT(FTRP(bp), PACK(bsize, 1));
+        }
+        debug_arm(bp, size);
+        STAT(stats.realloc_inplace++);
+        TOUCH(touch(bp));
+        return bp;
+    }
+
+    TOUCH(in_realloc = 1);
+    if ((newp = mm_malloc(size)) != NULL) {
+        memcpy(newp, bp, old_size < size ? old_size : size);
+        mm_free(bp);
+    }
+    TOUCH(in_realloc = 0);
+    return newp;
+}
+#endif
+
+/*----------------------------------------------mm_check()-----------------------------------------------------------*/
+
+/*
+ * check_error - 불변식 위반 하나를 (verbose면) 출력하고 1 return
+ */
+static int check_error(void *bp, char *msg, int verbose) {
+    if (verbose)
+        printf("mm_check: block %p: %s\n", bp, msg);
+    return 1;
+}
+
+/*
+ * check_block - 블록 하나의 경계 태그 검사: 정렬, 힙 범위, 최소 크기, header == footer
+ *     블록을 더 따라가면 안 될 만큼 깨졌으면 *fatal을 1로 설정
+ */
+static int check_block(char *bp, int verbose, int *fatal) {
+    char *lo = mem_heap_lo(), *hi = mem_heap_hi();
+    size_t size;
+
+    *fatal = 1;
+    if ((size_t)(bp - lo) % DSIZE != 0)
+        return check_error(bp, "payload is not aligned", verbose);
+    if (HDRP(bp) < lo || HDRP(bp) > hi - WSIZE + 1)
+        return check_error(bp, "header is outside the heap", verbose);
+    size = GET_SIZE(HDRP(bp));
+    if (size < 2 * DSIZE || size % DSIZE != 0)
+        return check_error(bp, "bad block size", verbose);
+    if (FTRP(bp) > hi - 2 * WSIZE + 1)
+        return check_error(bp, "block runs past the end of the heap", verbose);
+    *fatal = 0;
+    if (GET(HDRP(bp)) != GET(FTRP(bp)))
+        return check_error(bp, "header and footer differ", verbose);
+    return 0;
+}
+
+/*
+ * check_links - 가용블록 bp의 리스트 연결 검사: 클래스가 맞는지, pred/succ가 서로를 가리키는지
+ */
+static int check_links(char *bp, int verbose) {
+    char *lo = mem_heap_lo(), *hi = mem_heap_hi();
+    int class_idx = get_class(GET_SIZE(HDRP(bp)));
+    char *pred = PRED_FREEP(bp), *succ = SUCC_FREEP(bp);
+    int errs = 0;
+
+    if ((pred != NULL && (pred < lo || pred > hi)) || (succ != NULL && (succ < lo || succ > hi)))
+        return check_error(bp, "free list link points outside the heap", verbose);
+    if (pred == NULL && GET_ROOT(class_idx) != bp)
+        errs += check_error(bp, "free block has no pred but is not the root of its class", verbose);
+    if (pred != NULL && SUCC_FREEP(pred) != bp)
+        errs += check_error(bp, "succ of pred is not this block", verbose);
+    if (succ != NULL && PRED_FREEP(succ) != bp)
+        errs += check_error(bp, "pred of succ is not this block", verbose);
+    return errs;
+}
+
+/*
+ * check_full - 힙 전체를 한 번 훑고 비트맵으로 가용리스트와 대조 (O(힙 크기 + 가용블록 수))
+ */
+static int check_full(int verbose) {
+    char *lo = mem_heap_lo(), *hi = mem_heap_hi();
+    size_t nwords = (hi + 1 - lo) / DSIZE, nfree = 0, nlisted = 0, bit;
+    int errs = 0, fatal, prev_free = 0;
+    char *bp;
+
+    // 프롤로그 블록
+    if (GET(HDRP(class_listp)) != PACK((LISTLIMIT + 2) * WSIZE, 1) || GET(HDRP(class_listp)) != GET(FTRP(class_listp)))
+        return check_error(class_listp, "bad prologue block", verbose);
+
+    // 1) 주소 순으로 모든 블록: 경계 태그, 병합 안 된 가용블록, 가용블록 위치를 비트맵에 표시
+    memset(free_map, 0, nwords / 8 + 1);
+    for (bp = NEXT_BLKP(class_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
+        errs += check_block(bp, verbose, &fatal);
+        if (fatal)
+            return errs;
+        if (GET_ALLOC(HDRP(bp))) {
+            prev_free = 0;
+            continue;
+        }
+        if (prev_free)
+            errs += check_error(bp, "two consecutive free blocks were not coalesced", verbose);
+        prev_free = 1;
+        bit = (bp - lo) / DSIZE;
+        free_map[bit / 8] |= 1 << (bit % 8);
+        nfree++;
+    }
+    if (HDRP(bp) != hi - WSIZE + 1 || !GET_ALLOC(HDRP(bp)))
+        errs += check_error(bp, "bad epilogue block", verbose);
+
+    // 2) 클래스별 가용리스트: 방문한 블록의 비트를 지워서 중복(사이클)과 누락을 찾음
+    for (int i = 0; i < LISTLIMIT; i++) {
+        for (bp = GET_ROOT(i); bp != NULL; bp = SUCC_FREEP(bp)) {
+            if (bp < lo || bp > hi || (size_t)(bp - lo) % DSIZE != 0) {
+                errs += check_error(bp, "free list points outside the heap", verbose);
+                break;
+            }
+            bit = (bp - lo) / DSIZE;
+            if (!(free_map[bit / 8] & (1 << (bit % 8)))) {
+                errs += check_error(bp, "free list entry is not a free block, or is listed twice", verbose);
+                break;
+            }
+            free_map[bit / 8] &= ~(1 << (bit % 8));
+            nlisted++;
+            if (get_class(GET_SIZE(HDRP(bp))) != i)
+                errs += check_error(bp, "free block is in the wrong class", verbose);
+            errs += check_links(bp, verbose);
+        }
+    }
+    if (nlisted != nfree)
+        errs += check_error(NULL, "some free blocks are not in any free list", verbose);
+    return errs;
+}
+
+#ifdef MM_CHECK
+/*
+ * check_touched - 마지막 요청이 바꾼 블록과 그 이웃만 검사 (O(1))
+ */
+static int check_touched(int verbose) {
+    int errs = 0, fatal;
+    char *bp, *next, *prev;
+
+    for (int i = 0; i < ntouched; i++) {
+        bp = touched[i];
+        errs += check_block(bp, verbose, &fatal);
+        if (fatal)
+            continue;
+        next = NEXT_BLKP(bp);
+        if (GET_SIZE(HDRP(next)) > 0) {
+            errs += check_block(next, verbose, &fatal);
+            if (fatal)
+                continue;
+        }
+        prev = PREV_BLKP(bp);
+        if (prev < class_listp || prev >= bp)
+            errs += check_error(bp, "footer of the previous block is broken", verbose);
+        else if (GET(HDRP(bp) - WSIZE) != GET(HDRP(prev)))
+            errs += check_error(prev, "header and footer differ", verbose);
+        if (GET_ALLOC(HDRP(bp)))
+            continue;
+        if (!GET_ALLOC(HDRP(next)) || !GET_ALLOC(HDRP(bp) - WSIZE))
+            errs += check_error(bp, "free block has a free neighbour", verbose);
+        errs += check_links(bp, verbose);
+    }
+    return errs;
+}
+#endif
+
+/*
+ * mm_check - 힙 일관성 검사. full이면 힙 전체, 아니면 마지막 요청이 바꾼 블록만. 위반 개수 return
+ *            -DMM_CHECK 없이는 바뀐 블록을 기록하지 않으니 항상 힙 전체를 검사
+ */
+int mm_check(int full, int verbose) {
+    if (class_listp == NULL)
+        return 0;
+#ifdef MM_CHECK
+    if (!full)
+        return check_touched(verbose);
+#endif
+    return check_full(verbose);
+}
+
+/*----------------------------------------------mm_stats()-----------------------------------------------------------*/
+
+/*
+ * mm_stats - 이벤트 카운터(-DMM_STATS)와 클래스별 가용리스트 현황을 st에 복사
+ */
+void mm_stats(mm_stats_t *st) {
+    size_t limit = 16;
+    void *bp;
+
+#ifdef MM_STATS
+    *st = stats;
+    st->events = 1;
+#else
+    memset(st, 0, sizeof(mm_stats_t));
+#endif
+    st->nclasses = LISTLIMIT;
+    for (int i = 0; i < LISTLIMIT; i++) {
+        st->class_limit[i] = (i < LISTLIMIT - 1) ? limit : 0; // 마지막 클래스는 상한 없음
+        limit <<= 1;
+        st->class_free[i] = st->class_bytes[i] = 0;
+        if (class_listp == NULL)
+            continue;
+        for (bp = GET_ROOT(i); bp != NULL; bp = SUCC_FREEP(bp)) {
+            st->class_free[i]++;
+            st->class_bytes[i] += GET_SIZE(HDRP(bp));
+        }
+    }
+}
+
+/*
+ * mm_walk - 경계 태그(HDRP/NEXT_BLKP)를 따라 힙의 모든 블록을 주소 순으로 방문
+ */
+void mm_walk(mm_walk_fn fn, void *arg) {
+    char *bp;
+
+    if (class_listp == NULL)
+        return;
+    // 프롤로그 블록(class_listp) 다음부터 에필로그(size 0) 전까지
+    for (bp = NEXT_BLKP(class_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+        fn(HDRP(bp), GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)), arg);
+}
+
+/*----------------------------------------------mm_snapshot()-----------------------------------------------------------*/
+
+/*
+ * mm_snapshot - 할당기의 전역 상태 저장. 힙 내용은 호출자가 mem_snapshot으로 함께 저장해야 함.
+ *               guard page가 걸려 있으면 힙을 복사할 수 없으니 -1 return
+ */
+int mm_snapshot(void) {
+#ifdef MM_DEBUG
+    if (nguards > 0)
+        return -1;
+    snap.quarantine = quarantine;
+#endif
+#ifdef MM_STATS
+    snap.stats = stats;
+#endif
+    snap.heap_listp = heap_listp;
+    snap.class_listp = class_listp;
+    memcpy(snap.samples, samples, sizeof(samples));
+    memcpy(snap.life_avg, life_avg, sizeof(life_avg));
+    memcpy(snap.life_n, life_n, sizeof(life_n));
+    snap.now = now;
+    snap.sample_skip = sample_skip;
+    return 0;
+}
+
+/*
+ * mm_restore - mm_snapshot 시점의 전역 상태로 되돌림. 이후 걸린 guard page는 먼저 풀어서
+ *              호출자가 mem_restore로 힙 내용을 덮어쓸 수 있게 함
+ */
+void mm_restore(void) {
+#ifdef MM_DEBUG
+    debug_reset();
+    quarantine = snap.quarantine;
+#endif
+#ifdef MM_STATS
+    stats = snap.stats;
+#endif
+    heap_listp = snap.heap_listp;
+    class_listp = snap.class_listp;
+    memcpy(samples, snap.samples, sizeof(samples));
+    memcpy(life_avg, snap.life_avg, sizeof(life_avg));
+    memcpy(life_n, snap.life_n, sizeof(life_n));
+    now = snap.now;
+    sample_skip = snap.sample_skip;
+    TOUCH(touch_reset()); // 기록된 블록은 되돌린 힙과 맞지 않음
+}
@@ -5,6 +5,109 @@ extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 
+/*
+ * mm_free_sized - Free a block whose requested size the caller knows.
+ * The size is checked against the block (strictly with -DMM_DEBUG).
+ * mm_usable_size - Number of bytes of the block at ptr that the caller
+ * may use, which can be more than it asked for when the block was not
+ * split. Under -DMM_DEBUG it is exactly the requested size.
+ */
+extern void mm_free_sized(void *ptr, size_t size);
+extern size_t mm_usable_size(void *ptr);
+
+/*
+ * mm_malloc_batch - Allocate n blocks of size bytes into ptrs[], carved
+ * in a row out of one free block with a single split. Returns n, or 0
+ * if there is no memory (then nothing was allocated).
+ * mm_free_batch - Free the n blocks in ptrs[] (NULLs are skipped). The
+ * array is sorted by address, and each run of adjacent blocks is
+ * coalesced and put on a free list once.
+ */
+extern int mm_malloc_batch(size_t size, int n, void **ptrs);
+extern void mm_free_batch(void **ptrs, int n);
+
+/*
+ * mm_malloc_hint - mm_malloc with a hint of how long the block will
+ * live. Long-lived blocks are placed at the high end of free blocks
+ * and fresh chunks, so that short-lived blocks, which take the low
+ * end, leave one large free block behind when they die. With
+ * MM_HINT_NONE (and in mm_malloc) the lifetime is predicted from the
+ * size class, by sampling how long its earlier blocks lived.
+ */
+#define MM_HINT_NONE  0          /* predict the lifetime */
+#define MM_HINT_SHORT 1          /* the block dies soon */
+#define MM_HINT_LONG  2          /* the block outlives most others */
+
+extern void *mm_malloc_hint(size_t size, int hint);
+
+/*
+ * mm_stats - Internal statistics of the allocator. The free lists are
+ * scanned on every call. The event counters are only kept when mm.c is
+ * compiled with -DMM_STATS (then events is 1); otherwise they compile
+ * away and read as 0. mm_init resets them.
+ */
+#define MM_MAXCLASSES 32
+
+typedef struct {
+    int events;                  /* were the event counters compiled in? */
+
+    /* Event counters (-DMM_STATS) */
+    unsigned long mallocs;       /* mm_malloc calls */
+    unsigned long frees;         /* mm_free calls */
+    unsigned long reallocs;      /* mm_realloc calls */
+    unsigned long realloc_inplace; /* ... that kept the block in place */
+    unsigned long splits;        /* free blocks split by place */
+    unsigned long coalesces;     /* merges of neighbouring free blocks */
+    unsigned long sbrk_calls;    /* mem_sbrk calls */
+    unsigned long sbrk_bytes;    /* bytes obtained from mem_sbrk */
+    unsigned long fit_calls;     /* find_fit calls */
+    unsigned long fit_misses;    /* ... that found no block */
+    unsigned long fit_walk;      /* free blocks visited by find_fit */
+    unsigned long fit_walk_max;  /* most blocks visited by a single call */
+    unsigned long class_reqs[MM_MAXCLASSES]; /* requests mapped to class */
+    unsigned long class_hits[MM_MAXCLASSES]; /* fits found in class */
+
+    /* Snapshot of the free lists */
+    int nclasses;                /* number of size classes */
+    size_t class_limit[MM_MAXCLASSES]; /* largest size of class (0 = none) */
+    unsigned long class_free[MM_MAXCLASSES];  /* free blocks in class */
+    unsigned long class_bytes[MM_MAXCLASSES]; /* their total size */
+} mm_stats_t;
+
+extern void mm_stats(mm_stats_t *st);
+
+/*
+ * mm_walk - Call fn for every block of the heap, in address order, with
+ * the address and size of the whole block (header and footer included)
+ * and whether it is allocated
+ */
+typedef void (*mm_walk_fn)(void *blk, size_t size, int alloc, void *arg);
+
+extern void mm_walk(mm_walk_fn fn, void *arg);
+
+/*
+ * mm_check - Check the heap invariants: boundary tags, coalescing,
+ * free list membership, size classes and pred/succ link symmetry.
+ * A full check makes one linear pass over the heap and the free lists;
+ * otherwise only the blocks touched by the last request and their
+ * neighbours are checked, in constant time. Keeping track of those
+ * blocks costs time on every request, so it is only compiled in with
+ * -DMM_CHECK; without it, every check is a full one. Returns the
+ * number of violations found, and prints them if verbose.
+ */
+extern int mm_check(int full, int verbose);
+
+/*
+ * mm_snapshot - Save the allocator's global state (free list roots,
+ * lifetime predictor, counters). Together with mem_snapshot, which
+ * saves the heap itself, this lets a benchmark warm up the heap once
+ * and then time the same window of requests many times. Returns -1 if
+ * the heap can't be copied (-DMM_GUARD with guard pages in place).
+ * mm_restore - Go back to the last snapshot; call mem_restore after it.
+ */
+extern int mm_snapshot(void);
+extern void mm_restore(void);
+
 
 /* 
  * Students work in teams of one or two.  Teams enter their team name, 
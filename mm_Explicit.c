@@ -39,7 +39,7 @@ team_t team = {
 
 /* Read and write a word at address p */
 #define GET(p) (*(unsigned int *)(p))              // p가 참조하는 워드를 읽어서 리턴, p(void *)
-#define PUT(p, val) (GET(p) = (val)) // 인자 p가 가리키는 워드에 val 저장
+#define PUT(p, val) (GET(p) = (unsigned int)(val)) // 인자 p가 가리키는 워드에 val 저장
 
 /* Read the size and allocated fields from address p */
 #define GET_SIZE(p) (GET(p) & ~0x7) // 주소 p에 있는 header or footer의 size return
@@ -54,11 +54,10 @@ team_t team = {
 #define PREV_BLKP(bp) ((char *)(bp) - GET_SIZE(HDRP(bp) - WSIZE)) // 이전 블록의 포인터 return
 
 /* Given block ptr bp,compute address of next and previous Free list */
-#define PREC_FREEP(bp) (GET(bp)) 
-#define SUCC_FREEP(bp) (GET(bp + WSIZE))
+#define PREC_FREEP(bp) (*(void **)(bp))
+#define SUCC_FREEP(bp) (*(void **)((char *)(bp) + WSIZE))
 
 static char *heap_listp;
-static char *prev_bp = NULL;
 static char *free_listp = NULL;
 
 static void *extend_heap(size_t words);
@@ -161,7 +160,7 @@ static void *find_fit(size_t asize) {
     void *bp;
     bp = free_listp;
     // 가용리스트 내부의 유일한 할당 블록은 맨 뒤의 프롤로그 블록이므로 할당 블록을 만나면 for문을 종료한다.
-    for (bp; GET_ALLOC(HDRP(bp)) ==0; bp = SUCC_FREEP(bp)) {
+    for (; GET_ALLOC(HDRP(bp)) ==0; bp = SUCC_FREEP(bp)) {
         if (GET_SIZE(HDRP(bp)) >= asize) {
             return bp;
         }
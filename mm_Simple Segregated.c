@@ -150,7 +150,7 @@ static void *find_fit(size_t asize) {
     int class_n = getclass(asize);
     void *bp;
 
-    for (class_n; class_n < LISTLIMIT; class_n++) {
+    for (; class_n < LISTLIMIT; class_n++) {
         for (bp = GET_ROOT(class_n); bp != NULL; bp = SUCC_FREEP(bp)) {
             if (GET_SIZE(HDRP(bp)) >= asize) {
                 return bp;
@@ -0,0 +1,152 @@
+/*
+ * perfctr.c - hardware performance counters around a timed region
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfctr.h"
+
+char *pc_names[PC_NEVENTS] = {"instr", "L1D-miss", "LLC-miss", "dTLB-miss",
+			      "br-miss"};
+
+/* File descriptor of each counter, or -1 if it is not available */
+static int pc_fd[PC_NEVENTS] = {-1, -1, -1, -1, -1};
+
+#ifdef __linux__
+
+/* Config of a generalized cache event that counts read misses */
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* perf_event_open type and config of each event */
+static struct {
+    unsigned type;
+    unsigned long long config;
+} pc_events[PC_NEVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+/*
+ * pc_open - Open the counters, return how many are available
+ */
+int pc_open(int verbose)
+{
+    struct perf_event_attr attr;
+    int i, n = 0;
+
+    for (i = 0; i < PC_NEVENTS; i++) {
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = pc_events[i].type;
+	attr.config = pc_events[i].config;
+	attr.disabled = 1;
+	attr.inherit = 1;        /* count the replay threads, too */
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+	    PERF_FORMAT_TOTAL_TIME_RUNNING;
+	pc_fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (pc_fd[i] >= 0)
+	    n++;
+	else if (verbose)
+	    printf("Counter %s is not available: %s\n", pc_names[i],
+		   strerror(errno));
+    }
+    return n;
+}
+
+/*
+ * pc_start - Reset and start all available counters
+ */
+void pc_start(void)
+{
+    int i;
+
+    for (i = 0; i < PC_NEVENTS; i++)
+	if (pc_fd[i] >= 0) {
+	    ioctl(pc_fd[i], PERF_EVENT_IOC_RESET, 0);
+	    ioctl(pc_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+/*
+ * pc_stop - Stop the counters and read their (scaled) counts
+ */
+void pc_stop(double *counts)
+{
+    unsigned long long val[3]; /* value, time enabled, time running */
+    int i;
+
+    for (i = 0; i < PC_NEVENTS; i++)
+	if (pc_fd[i] >= 0)
+	    ioctl(pc_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    for (i = 0; i < PC_NEVENTS; i++) {
+	counts[i] = -1;
+	if (pc_fd[i] < 0 || read(pc_fd[i], val, sizeof(val)) != sizeof(val))
+	    continue;
+	if (val[2] == 0)
+	    counts[i] = 0;  /* never got onto the PMU */
+	else if (val[2] < val[1])
+	    counts[i] = (double)val[0] * val[1] / val[2];
+	else
+	    counts[i] = (double)val[0];
+    }
+}
+
+#else /* no perf_event_open */
+
+int pc_open(int verbose)
+{
+    if (verbose)
+	printf("Hardware counters are only supported on Linux\n");
+    return 0;
+}
+
+void pc_start(void)
+{
+}
+
+void pc_stop(double *counts)
+{
+    int i;
+
+    for (i = 0; i < PC_NEVENTS; i++)
+	counts[i] = -1;
+}
+
+#endif
+
+/*
+ * pc_available - Is counter i available?
+ */
+int pc_available(int i)
+{
+    return pc_fd[i] >= 0;
+}
+
+/*
+ * pc_close - Close all counters
+ */
+void pc_close(void)
+{
+    int i;
+
+    for (i = 0; i < PC_NEVENTS; i++)
+	if (pc_fd[i] >= 0) {
+	    close(pc_fd[i]);
+	    pc_fd[i] = -1;
+	}
+}
@@ -0,0 +1,42 @@
+/*
+ * perfctr.h - hardware performance counters around a timed region
+ *
+ * On Linux the counters are opened with perf_event_open(2) for the
+ * calling process (and the threads it creates), in user mode only.
+ * Each counter is opened on its own, so that a CPU, VM or kernel
+ * configuration without some events still gets the others. Elsewhere
+ * no counter is ever available.
+ */
+
+/* The events we count */
+#define PC_INSTR     0  /* instructions retired */
+#define PC_L1D_MISS  1  /* L1 data cache read misses */
+#define PC_LLC_MISS  2  /* last level cache misses */
+#define PC_DTLB_MISS 3  /* data TLB read misses */
+#define PC_BR_MISS   4  /* mispredicted branches */
+#define PC_NEVENTS   5
+
+/* Short event names, indexed by the PC_xxx constants */
+extern char *pc_names[PC_NEVENTS];
+
+/*
+ * pc_open - Open the counters and return how many are available. If
+ *     verbose, explain why the others are not.
+ */
+int pc_open(int verbose);
+
+/* Is counter i available? */
+int pc_available(int i);
+
+/* Reset and start all available counters */
+void pc_start(void);
+
+/*
+ * pc_stop - Stop the counters and store their counts in counts[],
+ *     scaled up if the kernel had to multiplex them. Unavailable
+ *     counters read as -1.
+ */
+void pc_stop(double *counts);
+
+/* Close all counters */
+void pc_close(void);
@@ -0,0 +1,92 @@
+/*
+ * region.c - region (arena) allocation on top of mm.c
+ */
+#include <stdio.h>
+
+#include "mm.h"
+#include "region.h"
+
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~(ALIGNMENT-1))
+
+/* Header of each chunk; the chunk's memory follows it */
+typedef struct chunk {
+    struct chunk *next;
+} chunk_t;
+
+#define CHUNK_HDR ALIGN(sizeof(chunk_t))
+
+struct region {
+    chunk_t *chunks;     /* all chunks, newest first */
+    char *cur;           /* next free byte of the current chunk... */
+    char *end;           /* ... and its end */
+    size_t chunk_size;   /* payload of a regular chunk */
+};
+
+/*
+ * new_chunk - Get a chunk with size bytes of payload from mm_malloc
+ */
+static char *new_chunk(region_t *r, size_t size)
+{
+    chunk_t *c;
+
+    if ((c = (chunk_t *)mm_malloc(CHUNK_HDR + size)) == NULL)
+	return NULL;
+    c->next = r->chunks;
+    r->chunks = c;
+    return (char *)c + CHUNK_HDR;
+}
+
+/*
+ * mm_region_create - Create an empty region
+ */
+region_t *mm_region_create(size_t chunk_size)
+{
+    region_t *r;
+
+    if ((r = (region_t *)mm_malloc(sizeof(region_t))) == NULL)
+	return NULL;
+    r->chunks = NULL;
+    r->cur = r->end = NULL;
+    r->chunk_size = chunk_size ? ALIGN(chunk_size) : REGION_CHUNK;
+    return r;
+}
+
+/*
+ * mm_region_alloc - Bump allocate size bytes from region r
+ */
+void *mm_region_alloc(region_t *r, size_t size)
+{
+    char *p;
+
+    /* A request of 0 bytes still gets a distinct, non-NULL block */
+    size = size ? ALIGN(size) : ALIGNMENT;
+    if (size > (size_t)(r->end - r->cur)) {
+	/* Large requests get a chunk of their own */
+	if (size > r->chunk_size / 4)
+	    return new_chunk(r, size);
+
+	/* Otherwise start a new current chunk */
+	if ((p = new_chunk(r, r->chunk_size)) == NULL)
+	    return NULL;
+	r->cur = p;
+	r->end = p + r->chunk_size;
+    }
+    p = r->cur;
+    r->cur += size;
+    return p;
+}
+
+/*
+ * mm_region_destroy - Free every chunk of region r, then r
+ */
+void mm_region_destroy(region_t *r)
+{
+    chunk_t *c, *next;
+
+    for (c = r->chunks; c != NULL; c = next) {
+	next = c->next;
+	mm_free(c);
+    }
+    mm_free(r);
+}
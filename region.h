@@ -0,0 +1,27 @@
+/*
+ * region.h - region (arena) allocation on top of mm.c
+ *
+ * A region hands out memory with a bump pointer inside chunks that it
+ * gets from mm_malloc, and gives it all back at once when it is
+ * destroyed, in time proportional to the number of chunks. Blocks of a
+ * region can't be freed or reallocated one by one.
+ */
+#include <stddef.h>
+
+#define REGION_CHUNK (4096 - 16) /* default chunk payload */
+
+typedef struct region region_t;
+
+/* Create a region with chunks of chunk_size bytes (0: REGION_CHUNK) */
+region_t *mm_region_create(size_t chunk_size);
+
+/*
+ * mm_region_alloc - Allocate size bytes from region r. Requests larger
+ *     than a quarter of a chunk get a chunk of their own, so they don't
+ *     waste the rest of the current one. A request of 0 bytes takes
+ *     ALIGNMENT bytes. Returns NULL if out of memory.
+ */
+void *mm_region_alloc(region_t *r, size_t size);
+
+/* Free all memory of region r, and r itself */
+void mm_region_destroy(region_t *r);
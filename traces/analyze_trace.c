@@ -0,0 +1,527 @@
+/*
+ * analyze_trace.c - report what makes a trace hard for an allocator
+ *
+ * For each trace file, prints the distribution of request sizes and of
+ * block lifetimes (in requests), the live set over time, the realloc
+ * chains, and bounds on the heap that the trace needs:
+ *
+ * - The peak live payload is the numerator of mdriver's utilization.
+ * - No allocator can use a smaller heap than the peak of the live
+ *   payloads, each rounded up to ALIGNMENT, since payloads must be
+ *   aligned and can't overlap. This is the lower bound.
+ * - An ideal first fit allocator with no headers, perfect coalescing
+ *   and in-place realloc whenever the next bytes are free needs a heap
+ *   at least as large as the optimal one. This is the upper bound.
+ *
+ * mdriver's utilization on the trace can't exceed peak / lower bound,
+ * so the distance from there is the headroom that an allocator has.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ALIGNMENT 8            /* as in ../config.h */
+#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~(size_t)(ALIGNMENT - 1))
+#define MAXREGIONS 1024        /* as in mdriver.c */
+#define NBINS 48               /* power-of-two histogram bins */
+#define DEFAULT_ROWS 16        /* rows of the live set over time */
+#define BAR 40                 /* width of the live set bars */
+
+/* A free gap of the ideal first fit heap, [lo, lo + len) */
+typedef struct {
+    size_t lo;
+    size_t len;
+} gap_t;
+
+/* What we know about each block id */
+typedef struct {
+    long born;                 /* request that allocated it, or -1 */
+    size_t size;               /* requested size */
+    size_t first;              /* size of the first allocation */
+    size_t addr;               /* offset in the ideal first fit heap */
+    int reallocs;              /* reallocs of this id */
+    int rnext;                 /* next block of the same region */
+} block_t;
+
+/* Statistics of one trace */
+typedef struct {
+    long nops, nallocs, nreallocs, nfrees;
+    int nthreads;
+    unsigned long size_count[NBINS];   /* requests by log2 size */
+    double size_bytes[NBINS];
+    unsigned long life_count[NBINS];   /* freed blocks by log2 lifetime */
+    unsigned long never;               /* blocks never freed */
+    unsigned long chain_count[NBINS];  /* ids by log2 number of reallocs */
+    unsigned long grew, shrank;        /* ids that ended bigger/smaller */
+    size_t live, live_aligned;         /* live payload now */
+    unsigned long live_blocks;
+    size_t peak, peak_aligned;         /* and at its peak */
+    long peak_op;
+} tstats_t;
+
+/* Ideal first fit heap: the gaps in address order, and the top */
+static gap_t *gaps = NULL;
+static int ngaps = 0, maxgaps = 0;
+static size_t top = 0, top_peak = 0;
+
+static int rows = DEFAULT_ROWS;
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * bin - Histogram bin of x: 0 for 0, 1 for 1, else i with
+ *     2^(i-2) < x <= 2^(i-1)
+ */
+static int bin(unsigned long x)
+{
+    int i = 1;
+
+    if (x == 0)
+	return 0;
+    while (i < NBINS - 1 && (1UL << (i - 1)) < x)
+	i++;
+    return i;
+}
+
+/*
+ * Ideal first fit heap
+ */
+
+/* find_gap - Index of the first gap that starts after lo */
+static int find_gap(size_t lo)
+{
+    int l = 0, r = ngaps, m;
+
+    while (l < r) {
+	m = (l + r) / 2;
+	if (gaps[m].lo <= lo)
+	    l = m + 1;
+	else
+	    r = m;
+    }
+    return l;
+}
+
+/* insert_gap - Return [lo, lo + len) to the heap, merging with neighbours */
+static void insert_gap(size_t lo, size_t len)
+{
+    int i = find_gap(lo);
+
+    if (len == 0)
+	return;
+    if (lo + len == top) {     /* top of the heap: shrink the used part */
+	top = lo;
+	if (i > 0 && gaps[i - 1].lo + gaps[i - 1].len == top) {
+	    top = gaps[i - 1].lo;
+	    ngaps--;
+	}
+	return;
+    }
+    if (i > 0 && gaps[i - 1].lo + gaps[i - 1].len == lo) {
+	gaps[i - 1].len += len;
+	if (i < ngaps && gaps[i].lo == lo + len) {
+	    gaps[i - 1].len += gaps[i].len;
+	    memmove(&gaps[i], &gaps[i + 1], (ngaps - i - 1) * sizeof(gap_t));
+	    ngaps--;
+	}
+	return;
+    }
+    if (i < ngaps && gaps[i].lo == lo + len) {
+	gaps[i].lo = lo;
+	gaps[i].len += len;
+	return;
+    }
+    if (ngaps == maxgaps) {
+	maxgaps = maxgaps ? 2 * maxgaps : 1024;
+	if ((gaps = (gap_t *)realloc(gaps, maxgaps * sizeof(gap_t))) == NULL)
+	    app_error("out of memory for the gaps");
+    }
+    memmove(&gaps[i + 1], &gaps[i], (ngaps - i) * sizeof(gap_t));
+    gaps[i].lo = lo;
+    gaps[i].len = len;
+    ngaps++;
+}
+
+/* ff_alloc - Place len bytes at the first gap that fits, or at the top */
+static size_t ff_alloc(size_t len)
+{
+    size_t lo;
+    int i;
+
+    for (i = 0; i < ngaps; i++)
+	if (gaps[i].len >= len) {
+	    lo = gaps[i].lo;
+	    gaps[i].lo += len;
+	    gaps[i].len -= len;
+	    if (gaps[i].len == 0) {
+		memmove(&gaps[i], &gaps[i + 1],
+			(ngaps - i - 1) * sizeof(gap_t));
+		ngaps--;
+	    }
+	    return lo;
+	}
+    lo = top;
+    top += len;
+    if (top > top_peak)
+	top_peak = top;
+    return lo;
+}
+
+/* ff_grow - Grow the block at lo from len to newlen in place, if we can */
+static int ff_grow(size_t lo, size_t len, size_t newlen)
+{
+    int i;
+
+    if (lo + len == top) {
+	top = lo + newlen;
+	if (top > top_peak)
+	    top_peak = top;
+	return 1;
+    }
+    i = find_gap(lo);
+    if (i < ngaps && gaps[i].lo == lo + len &&
+	gaps[i].len >= newlen - len) {
+	gaps[i].lo += newlen - len;
+	gaps[i].len -= newlen - len;
+	if (gaps[i].len == 0) {
+	    memmove(&gaps[i], &gaps[i + 1], (ngaps - i - 1) * sizeof(gap_t));
+	    ngaps--;
+	}
+	return 1;
+    }
+    return 0;
+}
+
+/*
+ * Replay of the requests
+ */
+
+static void do_alloc(tstats_t *ts, block_t *b, size_t size, long op)
+{
+    int i = bin(size);
+
+    ts->size_count[i]++;
+    ts->size_bytes[i] += size;
+    b->born = op;
+    b->size = b->first = size;
+    b->addr = ff_alloc(ALIGN(size));
+    ts->live += size;
+    ts->live_aligned += ALIGN(size);
+    ts->live_blocks++;
+}
+
+static void do_realloc(tstats_t *ts, block_t *b, size_t size)
+{
+    size_t oldlen = ALIGN(b->size), newlen = ALIGN(size), lo;
+    int i = bin(size);
+
+    ts->size_count[i]++;
+    ts->size_bytes[i] += size;
+    b->reallocs++;
+    if (newlen <= oldlen)
+	insert_gap(b->addr + newlen, oldlen - newlen);
+    else if (!ff_grow(b->addr, oldlen, newlen)) {
+	lo = ff_alloc(newlen);     /* copy, then free the old block */
+	insert_gap(b->addr, oldlen);
+	b->addr = lo;
+    }
+    ts->live += size - b->size;
+    ts->live_aligned += newlen - oldlen;
+    b->size = size;
+}
+
+static void do_free(tstats_t *ts, block_t *b, long op)
+{
+    ts->life_count[bin(op - b->born)]++;
+    ts->chain_count[bin(b->reallocs)]++;
+    if (b->reallocs > 0) {
+	if (b->size > b->first)
+	    ts->grew++;
+	else if (b->size < b->first)
+	    ts->shrank++;
+    }
+    insert_gap(b->addr, ALIGN(b->size));
+    ts->live -= b->size;
+    ts->live_aligned -= ALIGN(b->size);
+    ts->live_blocks--;
+    b->born = -1;
+}
+
+/*
+ * print_hist - Print the nonempty bins of a power-of-two histogram
+ */
+static void print_hist(char *title, char *unit, unsigned long *count,
+		       double *bytes, unsigned long total)
+{
+    double totbytes = 0;
+    char range[64];
+    int i;
+
+    if (total == 0)
+	return;
+    if (bytes)
+	for (i = 0; i < NBINS; i++)
+	    totbytes += bytes[i];
+    printf("%s:\n  %22s %10s %7s%s\n", title, unit, "count", "%",
+	   bytes ? "  bytes %" : "");
+    for (i = 0; i < NBINS; i++) {
+	if (count[i] == 0)
+	    continue;
+	if (i <= 2)
+	    sprintf(range, "%d", i);
+	else
+	    sprintf(range, "%lu-%lu", (1UL << (i - 2)) + 1, 1UL << (i - 1));
+	printf("  %22s %10lu %6.1f%%", range, count[i],
+	       100.0 * count[i] / total);
+	if (bytes)
+	    printf(" %8.1f%%", totbytes ? 100.0 * bytes[i] / totbytes : 0.0);
+	printf("\n");
+    }
+    printf("\n");
+}
+
+/*
+ * print_row - Print one row of the live set over time
+ */
+static void print_row(tstats_t *ts, long op, size_t maxlive)
+{
+    int n = maxlive ? (int)((double)BAR * ts->live / maxlive + 0.5) : 0;
+
+    printf("  %10ld %10lu %12lu  %.*s\n", op, ts->live_blocks,
+	   (unsigned long)ts->live, n,
+	   "########################################");
+}
+
+/*
+ * analyze - Read one trace and print its report. The trace is read
+ *     twice: first for the peak, which scales the bars, then for all
+ *     the rest.
+ */
+static void analyze(char *path)
+{
+    FILE *fp;
+    char type[64], *tag;
+    unsigned id, size, region;
+    int num_ids, num_ops, tid, pass, i, rhead[MAXREGIONS];
+    long op, every, next;
+    size_t maxlive = 0;
+    unsigned long total;
+    block_t *blocks;
+    tstats_t ts;
+
+    for (pass = 0; pass < 2; pass++) {
+	if ((fp = fopen(path, "r")) == NULL) {
+	    fprintf(stderr, "Could not open %s\n", path);
+	    exit(1);
+	}
+	if (fscanf(fp, "%*d %d %d %*d", &num_ids, &num_ops) != 2 ||
+	    num_ids < 0) {
+	    fprintf(stderr, "Bad header in %s\n", path);
+	    exit(1);
+	}
+	if ((blocks = (block_t *)calloc(num_ids + 1, sizeof(block_t))) == NULL)
+	    app_error("out of memory for the blocks");
+	for (i = 0; i < num_ids; i++)
+	    blocks[i].born = -1;
+	for (i = 0; i < MAXREGIONS; i++)
+	    rhead[i] = -1;
+	memset(&ts, 0, sizeof(ts));
+	ts.nthreads = 1;
+	ngaps = 0;
+	top = top_peak = 0;
+	every = (num_ops / rows > 0) ? num_ops / rows : 1;
+	next = every;
+	if (pass == 1) {
+	    printf("%s: %d ids\n\n", path, num_ids);
+	    printf("Live set over time:\n  %10s %10s %12s\n",
+		   "request", "blocks", "bytes");
+	}
+
+	op = 0;
+	while (fscanf(fp, "%63s", type) == 1) {
+	    tid = 0;
+	    if ((tag = strchr(type, '@')) != NULL)
+		tid = atoi(tag + 1);
+	    if (tid + 1 > ts.nthreads)
+		ts.nthreads = tid + 1;
+	    region = 0;
+	    size = 0;
+	    if (type[0] == 'a' || type[0] == 'r') {
+		if (fscanf(fp, "%u %u", &id, &size) != 2)
+		    break;
+	    }
+	    else if (type[0] == 'g') {
+		if (fscanf(fp, "%u %u %u", &region, &id, &size) != 3)
+		    break;
+	    }
+	    else if (type[0] == 'd') {
+		if (fscanf(fp, "%u", &region) != 1)
+		    break;
+		id = 0;
+	    }
+	    else if (type[0] == 'f' || type[0] == 'x') {
+		if (fscanf(fp, "%u", &id) != 1)
+		    break;
+	    }
+	    else {
+		fprintf(stderr, "Bogus request %s in %s\n", type, path);
+		exit(1);
+	    }
+	    if ((int)id >= num_ids || region >= MAXREGIONS) {
+		fprintf(stderr, "Request %s %u out of range in %s\n",
+			type, id, path);
+		exit(1);
+	    }
+
+	    if ((type[0] == 'a' || type[0] == 'g') && blocks[id].born >= 0) {
+		fprintf(stderr, "Alloc of live block %u in %s\n", id, path);
+		exit(1);
+	    }
+
+	    switch (type[0]) {
+	    case 'g':
+		blocks[id].rnext = rhead[region];
+		rhead[region] = id;
+		/* fall through */
+	    case 'a':
+		ts.nallocs++;
+		do_alloc(&ts, &blocks[id], size, op++);
+		break;
+	    case 'r':
+		ts.nreallocs++;
+		op++;
+		if (blocks[id].born < 0)
+		    do_alloc(&ts, &blocks[id], size, op - 1);
+		else
+		    do_realloc(&ts, &blocks[id], size);
+		break;
+	    case 'd': /* a free of each block of the region, as in mdriver */
+		for (i = rhead[region]; i >= 0; i = blocks[i].rnext) {
+		    if (blocks[i].born < 0) {
+			fprintf(stderr, "Free of dead block %d in %s\n", i, path);
+			exit(1);
+		    }
+		    ts.nfrees++;
+		    do_free(&ts, &blocks[i], op++);
+		}
+		rhead[region] = -1;
+		break;
+	    default:
+		if (blocks[id].born < 0) {
+		    fprintf(stderr, "Free of dead block %u in %s\n", id, path);
+		    exit(1);
+		}
+		ts.nfrees++;
+		do_free(&ts, &blocks[id], op++);
+		break;
+	    }
+
+	    if (ts.live > ts.peak) {
+		ts.peak = ts.live;
+		ts.peak_op = op;
+	    }
+	    if (ts.live_aligned > ts.peak_aligned)
+		ts.peak_aligned = ts.live_aligned;
+	    if (pass == 1 && op >= next) {
+		print_row(&ts, op, maxlive);
+		next = op + every;
+	    }
+	}
+	fclose(fp);
+	maxlive = ts.peak;
+	if (pass == 0)
+	    free(blocks);
+    }
+    ts.nops = op;
+    if (next != op + every)
+	print_row(&ts, op, maxlive);
+    printf("\n");
+
+    /* Blocks that are still live were never freed */
+    for (i = 0; i < num_ids; i++)
+	if (blocks[i].born >= 0) {
+	    ts.never++;
+	    ts.chain_count[bin(blocks[i].reallocs)]++;
+	}
+    free(blocks);
+
+    printf("%ld requests: %ld allocs, %ld reallocs, %ld frees, "
+	   "%d thread%s\n\n", ts.nops, ts.nallocs, ts.nreallocs, ts.nfrees,
+	   ts.nthreads, ts.nthreads > 1 ? "s" : "");
+    print_hist("Request sizes", "bytes", ts.size_count, ts.size_bytes,
+	       ts.nallocs + ts.nreallocs);
+    print_hist("Lifetimes of the freed blocks", "requests", ts.life_count,
+	       NULL, ts.nfrees);
+    if (ts.never)
+	printf("%lu blocks are never freed\n\n", ts.never);
+    if (ts.nreallocs > 0) {
+	for (total = 0, i = 0; i < NBINS; i++)
+	    total += ts.chain_count[i];
+	print_hist("Realloc chains", "reallocs per id", ts.chain_count,
+		   NULL, total);
+	printf("%lu ids ended larger than they started, %lu smaller\n\n",
+	       ts.grew, ts.shrank);
+    }
+
+    printf("Heap size:\n");
+    printf("  peak live payload %10lu bytes at request %ld\n",
+	   (unsigned long)ts.peak, ts.peak_op);
+    printf("  lower bound       %10lu bytes (aligned payloads)\n",
+	   (unsigned long)ts.peak_aligned);
+    printf("  ideal first fit   %10lu bytes (no headers, perfect "
+	   "coalescing)\n", (unsigned long)top_peak);
+    printf("  best possible util %5.1f%%, ideal first fit %5.1f%%\n\n",
+	   ts.peak_aligned ? 100.0 * ts.peak / ts.peak_aligned : 0.0,
+	   top_peak ? 100.0 * ts.peak / top_peak : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+
+    while ((c = getopt(argc, argv, "hr:")) != EOF) {
+	switch (c) {
+	case 'r': /* Rows of the live set over time */
+	    rows = atoi(optarg);
+	    if (rows < 1)
+		app_error("the number of rows (-r) must be at least 1");
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (optind == argc) {
+	usage();
+	exit(1);
+    }
+    for (; optind < argc; optind++)
+	analyze(argv[optind]);
+    return 0;
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+    fprintf(stderr, "Usage: analyze_trace [-h] [-r <rows>] <file>...\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-r <rows>  Print the live set at <rows> points (default %d).\n",
+	    DEFAULT_ROWS);
+}
+
+/*
+ * app_error - Report an error and exit
+ */
+static void app_error(char *msg)
+{
+    fprintf(stderr, "analyze_trace: %s\n", msg);
+    exit(1);
+}
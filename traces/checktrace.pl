@@ -78,9 +78,36 @@ while ($line = <STDIN>) {
 	next;
     }
 
+    # drop the thread of multithreaded traces ("a@<tid>"), and check 
+    # remote frees ("x") like any other free
+    ($cmd, $tid) = split("@", $cmd);
+    $cmd = "f" if $cmd eq "x";
+
     # save the line for output later
     $lines[$requestnum++] = $line;
 
+    # region allocations ("g <region> <id> <size>") are remembered by
+    # region, and a region destroy ("d <region>") frees all of them
+    if ($cmd eq "g") {
+	($cmd, $region, $id, $size) = split(" ", $line);
+	if (exists($HASH{$id})) {
+	    die "$0: ERROR[$linenum]: reused ID $id.\n";
+	}
+	$HASH{$id} = "g";
+	push @{$REGION{$region}}, $id;
+	next;
+    }
+    if ($cmd eq "d") {
+	foreach $member (@{$REGION{$id}}) {
+	    delete $HASH{$member};
+	}
+	delete $REGION{$id};
+	next;
+    }
+    if (($cmd eq "r" or $cmd eq "f") and $HASH{$id} eq "g") {
+	die "$0: ERROR[$linenum]: realloc or free of a region block.\n";
+    }
+
     #ignore realloc requests, as long as they are preceeded by an alloc request
     if ($cmd eq "r") {
 	if (!$HASH{$id}) {
@@ -131,7 +158,7 @@ if ($summary) {
 #
 # Output a balanced version of the trace
 #
-$new_ops = keys %HASH;
+$new_ops = (grep { $HASH{$_} ne "g" } keys %HASH) + (keys %REGION);
 $new_num_ops = $old_num_ops + $new_ops;
 
 print "$heap_size\n";
@@ -146,10 +173,16 @@ foreach $item (@lines) {
 
 # print a set of free requests that will balance the trace
 foreach $key (sort keys %HASH) {
+    next if $HASH{$key} eq "g";
     if ($HASH{$key} ne "a" and $HASH{$key} ne "r") {
 	die "$0: ERROR: Invalid free request in residue.\n";
     }
     print "f $key\n";
 }
 
+# and destroy the regions that are still live
+foreach $region (sort keys %REGION) {
+    print "d $region\n";
+}
+
 exit;
@@ -0,0 +1,78 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# gen_pipeline.pl - pipeline trace for multithreaded replay
+#
+# Each item passes through S stages, one thread per stage. Stage 0
+# allocates the item, every middle stage grows it with a realloc on its
+# own thread, and the last stage releases it with a remote free
+# ("x@<tid> <id>"). Up to $in_flight items are in the pipeline at once,
+# and the stages take turns at random, as they would under a scheduler.
+#
+$out_filename = $ARGV[0];
+$out_filename = "pipeline.rep" unless $out_filename;
+$num_stages = $ARGV[1];
+$num_stages = 4 unless $num_stages;
+$num_items = $ARGV[2];
+$num_items = 3000 unless $num_items;
+$max_item_size = $ARGV[3];
+$max_item_size = 256 unless $max_item_size;
+$in_flight = 32;
+
+die "Need at least 2 stages\n" if $num_stages < 2;
+
+# Create trace. @stage holds, for each item in flight, the stage it
+# will visit next, and @size its current size.
+$next_item = 0;
+$done = 0;
+%stage = ();
+%size = ();
+while ($done < $num_items) {
+    @ready = sort { $a <=> $b } keys %stage;
+    if ($next_item < $num_items && @ready < $in_flight && 
+        (!@ready || rand() < 1.0 / $num_stages)) {
+        # Stage 0 creates a new item
+        $size{$next_item} = 1 + int(rand $max_item_size);
+        push @trace, "a\@0 $next_item $size{$next_item}";
+        $stage{$next_item} = 1;
+        $next_item++;
+        next;
+    }
+
+    # Advance the oldest item in flight at a randomly chosen stage
+    $s = 1 + int(rand($num_stages - 1));
+    foreach $item (@ready) {
+        next unless $stage{$item} == $s;
+        if ($s < $num_stages - 1) {
+            $size{$item} += 1 + int(rand $max_item_size);
+            push @trace, "r\@$s $item $size{$item}";
+            $stage{$item}++;
+        } else {
+            push @trace, "x\@$s $item";
+            delete $stage{$item};
+            delete $size{$item};
+            $done++;
+        }
+        last;
+    }
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $in_flight * $num_stages * $max_item_size + 100;
+$num_blocks = $num_items;
+$num_ops = scalar @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $op (@trace) {
+    print OUTFILE "$op\n";
+}
+
+close OUTFILE;
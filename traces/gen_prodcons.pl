@@ -0,0 +1,70 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# gen_prodcons.pl - producer/consumer trace for multithreaded replay
+#
+# Producer threads (tids 0..P-1) allocate messages and put them on a
+# bounded queue; consumer threads (tids P..P+C-1) take the oldest message
+# off the queue and release it with a remote free ("x@<tid> <id>").
+# Producers also use a short-lived scratch buffer now and then, which
+# they allocate and free themselves.
+#
+$out_filename = $ARGV[0];
+$out_filename = "prodcons.rep" unless $out_filename;
+$num_producers = $ARGV[1];
+$num_producers = 2 unless $num_producers;
+$num_consumers = $ARGV[2];
+$num_consumers = 2 unless $num_consumers;
+$num_msgs = $ARGV[3];
+$num_msgs = 4000 unless $num_msgs;
+$max_msg_size = $ARGV[4];
+$max_msg_size = 512 unless $max_msg_size;
+$queue_depth = 64;
+
+# Create trace
+$id = 0;
+$produced = 0;
+@queue = ();
+while ($produced < $num_msgs || @queue) {
+    if ($produced < $num_msgs && @queue < $queue_depth && 
+        (!@queue || rand() < 0.5)) {
+        # A producer allocates a message and enqueues it
+        $tid = int(rand $num_producers);
+        if (rand() < 0.25) {
+            $scratch = $id++;
+            push @trace, "a\@$tid $scratch " . (1 + int(rand 4096));
+            $free_scratch = "f\@$tid $scratch";
+        } else {
+            $free_scratch = "";
+        }
+        push @trace, "a\@$tid $id " . (1 + int(rand $max_msg_size));
+        push @queue, $id++;
+        push @trace, $free_scratch if $free_scratch;
+        $produced++;
+    } else {
+        # A consumer dequeues the oldest message and frees it
+        $tid = $num_producers + int(rand $num_consumers);
+        $msg = shift @queue;
+        push @trace, "x\@$tid $msg";
+    }
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $queue_depth * $max_msg_size + 4096 + 100;
+$num_blocks = $id;
+$num_ops = scalar @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $op (@trace) {
+    print OUTFILE "$op\n";
+}
+
+close OUTFILE;
@@ -0,0 +1,81 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# gen_region.pl - request-scoped allocations for the region API
+#
+# Up to $max_live requests are in flight at a time. Each one allocates
+# a few dozen small objects in a region of its own ("g <region> <id>
+# <bytes>") and releases them all at once when it completes
+# ("d <region>"). Now and then a request also allocates a long-lived
+# object with plain malloc, which a later request frees.
+#
+$out_filename = $ARGV[0];
+$out_filename = "region.rep" unless $out_filename;
+$num_requests = $ARGV[1];
+$num_requests = 400 unless $num_requests;
+$max_objs = $ARGV[2];
+$max_objs = 64 unless $max_objs;
+$max_obj_size = $ARGV[3];
+$max_obj_size = 256 unless $max_obj_size;
+$max_live = 4;
+
+# Create trace
+$id = 0;
+$started = 0;
+$max_region = 0;
+@free_regions = (0 .. $max_live - 1);
+%left = ();          # objects still to allocate, by region
+@long_lived = ();
+while ($started < $num_requests || %left) {
+    if ($started < $num_requests && @free_regions && 
+        (!%left || rand() < 0.3)) {
+        # Start a request in a free region
+        $region = shift @free_regions;
+        $left{$region} = 1 + int(rand $max_objs);
+        $started++;
+        next;
+    }
+
+    # Let a random request in flight make progress
+    @live = keys %left;
+    $region = $live[int(rand @live)];
+    if ($left{$region}-- > 0) {
+        push @trace, "g $region $id " . (1 + int(rand $max_obj_size));
+        $id++;
+        if (rand() < 0.02) {
+            push @trace, "a $id " . (1 + int(rand 4096));
+            push @long_lived, $id++;
+        }
+        if (@long_lived > 16 && rand() < 0.05) {
+            push @trace, "f " . shift @long_lived;
+        }
+    } else {
+        # The request is done: free everything it allocated at once
+        push @trace, "d $region";
+        delete $left{$region};
+        push @free_regions, $region;
+    }
+}
+foreach $long (@long_lived) {
+    push @trace, "f $long";
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $max_live * $max_objs * $max_obj_size + 16 * 4096;
+$num_blocks = $id;
+$num_ops = scalar @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $op (@trace) {
+    print OUTFILE "$op\n";
+}
+
+close OUTFILE;
@@ -0,0 +1,467 @@
+/*
+ * gen_workload.c - generate large traces with realistic size and
+ *     lifetime distributions
+ *
+ * The gen_*.pl scripts write a few thousand requests of one fixed
+ * pattern. This generator writes millions of requests in seconds.
+ * Sizes and lifetimes are drawn from configurable distributions, the
+ * live payload settles into a steady-state working set, and the size
+ * distribution can shift between phases. The output is deterministic
+ * for a given seed and balanced: the blocks still live at the end are
+ * freed in the order they would have died.
+ *
+ * Lifetimes are counted in requests. A block is freed once that many
+ * requests have been written since its allocation, or earlier if the
+ * live payload would exceed the working set (then the block closest
+ * to its death goes first).
+ *
+ * Distributions are given as comma-separated specs:
+ *
+ *   uniform,<lo>,<hi>               uniform on [lo, hi]
+ *   pow,<alpha>,<lo>,<hi>           power law (bounded Pareto) on [lo, hi]
+ *   lognormal,<mu>,<sigma>[,<lo>,<hi>]  exp(N(mu, sigma)), clamped
+ *   exp,<mean>[,<lo>,<hi>]          exponential, clamped
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#define MAXSIZE (1 << 20)          /* largest request size */
+#define MAXLIFE 1e15               /* "never dies" */
+
+#define DEFAULT_OPS 1000000
+#define DEFAULT_SIZES "pow,1.5,16,65536"
+#define DEFAULT_LIVES "lognormal,7,2"
+#define DEFAULT_WSET (8 << 20)     /* well below the driver's MAX_HEAP */
+
+/* A distribution parsed from a spec */
+typedef struct {
+    enum {UNIFORM, POW, LOGNORMAL, EXP} kind;
+    double a, b;                   /* parameters */
+    double lo, hi;                 /* bounds of the result */
+} dist_t;
+
+/* One request of the trace */
+typedef struct {
+    char type;                     /* 'a', 'r' or 'f' */
+    int id;
+    int size;
+} op_t;
+
+/* The trace being generated */
+static op_t *ops = NULL;
+static long nops = 0, maxops = 0;
+
+/* State of each block id */
+static double *death = NULL;       /* request count at which it dies */
+static int *bsize = NULL;          /* current size */
+static int *lpos = NULL;           /* index in live[], or -1 if freed */
+static int nids = 0, maxids = 0;
+
+/* Live blocks, in no particular order, and their total size */
+static int *live = NULL;
+static int nlive = 0;
+static long live_bytes = 0, peak_bytes = 0;
+
+/* Min-heap of block ids by death; freed ids are skipped when popped */
+static int *heap = NULL;
+static int nheap = 0;
+
+static unsigned long long rng;     /* xorshift64* state */
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * Random numbers. Our own generator, so that a seed gives the same
+ * trace on every platform.
+ */
+static void seed_rng(unsigned long long seed)
+{
+    /* splitmix64, so that nearby seeds give unrelated streams */
+    seed += 0x9e3779b97f4a7c15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+    rng = (seed ^ (seed >> 31)) | 1;
+}
+
+/* uniform - Uniform double in [0, 1) */
+static double uniform(void)
+{
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return ((rng * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* normal - Standard normal (Box-Muller) */
+static double normal(void)
+{
+    return sqrt(-2.0 * log(1.0 - uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+/*
+ * parse_dist - Parse a distribution spec (see the top of the file).
+ *     Results are clamped to [1, max] unless the spec gives bounds.
+ */
+static void parse_dist(char *spec, dist_t *d, double max)
+{
+    char buf[256], *name, *tok;
+    double p[4];
+    int n = 0;
+
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    name = strtok(buf, ",");
+    while (n < 4 && (tok = strtok(NULL, ",")) != NULL)
+	p[n++] = atof(tok);
+    d->lo = 1;
+    d->hi = max;
+    if (name == NULL)
+	app_error("empty distribution");
+    if (!strcmp(name, "uniform") && n == 2) {
+	d->kind = UNIFORM;
+	d->lo = p[0];
+	d->hi = p[1];
+    }
+    else if (!strcmp(name, "pow") && n == 3) {
+	d->kind = POW;
+	d->a = p[0];
+	d->lo = p[1];
+	d->hi = p[2];
+    }
+    else if (!strcmp(name, "lognormal") && (n == 2 || n == 4)) {
+	d->kind = LOGNORMAL;
+	d->a = p[0];
+	d->b = p[1];
+	if (n == 4) {
+	    d->lo = p[2];
+	    d->hi = p[3];
+	}
+    }
+    else if (!strcmp(name, "exp") && (n == 1 || n == 3)) {
+	d->kind = EXP;
+	d->a = p[0];
+	if (n == 3) {
+	    d->lo = p[1];
+	    d->hi = p[2];
+	}
+    }
+    else {
+	fprintf(stderr, "Bad distribution \"%s\"\n", spec);
+	usage();
+	exit(1);
+    }
+    if (d->lo < 1 || d->hi < d->lo || d->hi > max ||
+	(d->kind == POW && d->a <= 0)) {
+	fprintf(stderr, "Bad parameters in distribution \"%s\"\n", spec);
+	exit(1);
+    }
+}
+
+/*
+ * sample - Draw from distribution d
+ */
+static double sample(dist_t *d)
+{
+    double x, r;
+
+    switch (d->kind) {
+    case UNIFORM:
+	x = d->lo + floor(uniform() * (d->hi - d->lo + 1));
+	break;
+    case POW: /* inverse CDF of the Pareto distribution cut at hi */
+	r = pow(d->lo / d->hi, d->a);
+	x = d->lo / pow(1.0 - uniform() * (1.0 - r), 1.0 / d->a);
+	break;
+    case LOGNORMAL:
+	x = exp(d->a + d->b * normal());
+	break;
+    default: /* EXP */
+	x = -d->a * log(1.0 - uniform());
+	break;
+    }
+    if (x < d->lo)
+	x = d->lo;
+    if (x > d->hi)
+	x = d->hi;
+    return x;
+}
+
+/*
+ * emit - Append a request to the trace
+ */
+static void emit(char type, int id, int size)
+{
+    if (nops == maxops) {
+	maxops = maxops ? 2 * maxops : 1 << 16;
+	if ((ops = (op_t *)realloc(ops, maxops * sizeof(op_t))) == NULL)
+	    app_error("out of memory for the requests");
+    }
+    ops[nops].type = type;
+    ops[nops].id = id;
+    ops[nops].size = size;
+    nops++;
+}
+
+/*
+ * heap_push, heap_pop - The min-heap of block ids by death
+ */
+static void heap_push(int id)
+{
+    int i = nheap++, parent;
+
+    while (i > 0 && death[heap[parent = (i - 1) / 2]] > death[id]) {
+	heap[i] = heap[parent];
+	i = parent;
+    }
+    heap[i] = id;
+}
+
+static int heap_pop(void)
+{
+    int top = heap[0], last = heap[--nheap], i = 0, child;
+
+    while ((child = 2 * i + 1) < nheap) {
+	if (child + 1 < nheap && death[heap[child + 1]] < death[heap[child]])
+	    child++;
+	if (death[heap[child]] >= death[last])
+	    break;
+	heap[i] = heap[child];
+	i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/*
+ * new_block - Allocate block id of size bytes that lives for life requests
+ */
+static int new_block(int size, double life)
+{
+    int id = nids++;
+
+    if (nids > maxids) {
+	maxids = maxids ? 2 * maxids : 1 << 16;
+	if ((death = (double *)realloc(death, maxids * sizeof(double))) == NULL ||
+	    (bsize = (int *)realloc(bsize, maxids * sizeof(int))) == NULL ||
+	    (lpos = (int *)realloc(lpos, maxids * sizeof(int))) == NULL ||
+	    (live = (int *)realloc(live, maxids * sizeof(int))) == NULL ||
+	    (heap = (int *)realloc(heap, maxids * sizeof(int))) == NULL)
+	    app_error("out of memory for the blocks");
+    }
+    death[id] = nops + life;
+    bsize[id] = size;
+    lpos[id] = nlive;
+    live[nlive++] = id;
+    live_bytes += size;
+    if (live_bytes > peak_bytes)
+	peak_bytes = live_bytes;
+    heap_push(id);
+    emit('a', id, size);
+    return id;
+}
+
+/*
+ * free_block - Free live block id
+ */
+static void free_block(int id)
+{
+    int last = live[--nlive];
+
+    live[lpos[id]] = last;
+    lpos[last] = lpos[id];
+    lpos[id] = -1;
+    live_bytes -= bsize[id];
+    emit('f', id, 0);
+}
+
+/*
+ * free_next - Free the live block that dies first. Returns 0 if there
+ *     is none, or if it isn't due yet and due is set.
+ */
+static int free_next(int due)
+{
+    int id;
+
+    while (nheap > 0) {
+	id = heap[0];
+	if (lpos[id] < 0) {       /* freed by a phase change */
+	    heap_pop();
+	    continue;
+	}
+	if (due && death[id] > nops)
+	    return 0;
+	free_block(heap_pop());
+	return 1;
+    }
+    return 0;
+}
+
+/*
+ * write_trace - Write the trace in the driver's format
+ */
+static void write_trace(FILE *fp)
+{
+    long i;
+
+    fprintf(fp, "%ld\n%d\n%ld\n1\n", peak_bytes, nids, nops);
+    for (i = 0; i < nops; i++)
+	if (ops[i].type == 'f')
+	    fprintf(fp, "f %d\n", ops[i].id);
+	else
+	    fprintf(fp, "%c %d %d\n", ops[i].type, ops[i].id, ops[i].size);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    char *outfile = NULL;
+    char *size_spec = DEFAULT_SIZES, *life_spec = DEFAULT_LIVES;
+    long target = DEFAULT_OPS, wset = DEFAULT_WSET;
+    unsigned long long seed = 1;
+    int phases = 1, phase = 0, size, id, i;
+    double realloc_frac = 0.0, scale = 1.0;
+    dist_t sizes, lives;
+    FILE *fp = stdout;
+
+    while ((c = getopt(argc, argv, "ho:n:s:S:L:w:p:r:")) != EOF) {
+	switch (c) {
+	case 'o': /* Output file */
+	    outfile = optarg;
+	    break;
+	case 'n': /* Number of requests before the final frees */
+	    target = atol(optarg);
+	    break;
+	case 's': /* Seed */
+	    seed = strtoull(optarg, NULL, 0);
+	    break;
+	case 'S': /* Size distribution */
+	    size_spec = optarg;
+	    break;
+	case 'L': /* Lifetime distribution */
+	    life_spec = optarg;
+	    break;
+	case 'w': /* Working set: most live payload in bytes */
+	    wset = atol(optarg);
+	    break;
+	case 'p': /* Number of phases */
+	    phases = atoi(optarg);
+	    break;
+	case 'r': /* Fraction of requests that are reallocs */
+	    realloc_frac = atof(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (target < 1 || phases < 1 || wset < 1 ||
+	realloc_frac < 0.0 || realloc_frac >= 1.0) {
+	usage();
+	exit(1);
+    }
+    parse_dist(size_spec, &sizes, MAXSIZE);
+    parse_dist(life_spec, &lives, MAXLIFE);
+    seed_rng(seed);
+
+    while (nops < target) {
+	/* Free the blocks whose time has come */
+	while (free_next(1))
+	    ;
+
+	/*
+	 * At each new phase, sizes shift by a random factor between 1/4
+	 * and 4, and each live block is freed with probability 1/2
+	 */
+	if (nops >= (phase + 1) * (target / phases) && phase < phases - 1) {
+	    phase++;
+	    scale = pow(2.0, 4.0 * uniform() - 2.0);
+	    for (i = nlive - 1; i >= 0; i--)
+		if (uniform() < 0.5)
+		    free_block(live[i]);
+	}
+
+	size = (int)(sample(&sizes) * scale);
+	if (size < 1)
+	    size = 1;
+	if (size > MAXSIZE)
+	    size = MAXSIZE;
+	if (size > wset)
+	    size = wset;
+
+	/* Make room in the working set, then realloc or allocate */
+	if (nlive > 0 && uniform() < realloc_frac) {
+	    id = live[(int)(uniform() * nlive)];
+	    while (live_bytes - bsize[id] + size > wset && free_next(0))
+		if (lpos[id] < 0)
+		    break;
+	    if (lpos[id] < 0)
+		continue;         /* we had to free it */
+	    live_bytes += size - bsize[id];
+	    if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+	    bsize[id] = size;
+	    emit('r', id, size);
+	}
+	else {
+	    while (live_bytes + size > wset && free_next(0))
+		;
+	    new_block(size, floor(sample(&lives)));
+	}
+    }
+
+    /* Balance the trace */
+    while (free_next(0))
+	;
+
+    if (outfile && (fp = fopen(outfile, "w")) == NULL) {
+	fprintf(stderr, "Cannot create %s\n", outfile);
+	exit(1);
+    }
+    write_trace(fp);
+    if (fp != stdout)
+	fclose(fp);
+    fprintf(stderr, "%ld requests, %d ids, peak live payload %ld bytes\n",
+	    nops, nids, peak_bytes);
+    return 0;
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+    fprintf(stderr, "Usage: gen_workload [-h] [-o <file>] [-n <ops>] [-s <seed>]\n");
+    fprintf(stderr, "                    [-S <dist>] [-L <dist>] [-w <bytes>] [-p <n>] [-r <frac>]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-o <file>  Write the trace to <file> (default: stdout).\n");
+    fprintf(stderr, "\t-n <ops>   Generate <ops> requests, then free the live blocks (default %d).\n",
+	    DEFAULT_OPS);
+    fprintf(stderr, "\t-s <seed>  Seed of the random numbers (default 1).\n");
+    fprintf(stderr, "\t-S <dist>  Size distribution in bytes (default %s).\n",
+	    DEFAULT_SIZES);
+    fprintf(stderr, "\t-L <dist>  Lifetime distribution in requests (default %s).\n",
+	    DEFAULT_LIVES);
+    fprintf(stderr, "\t-w <bytes> Keep the live payload under <bytes> (default %d).\n",
+	    DEFAULT_WSET);
+    fprintf(stderr, "\t-p <n>     Split the trace into <n> phases with different sizes.\n");
+    fprintf(stderr, "\t-r <frac>  Make a fraction <frac> of the requests reallocs.\n");
+    fprintf(stderr, "Distributions: uniform,<lo>,<hi>  pow,<alpha>,<lo>,<hi>\n");
+    fprintf(stderr, "               lognormal,<mu>,<sigma>[,<lo>,<hi>]  exp,<mean>[,<lo>,<hi>]\n");
+}
+
+/*
+ * app_error - Report an error and exit
+ */
+static void app_error(char *msg)
+{
+    fprintf(stderr, "gen_workload: %s\n", msg);
+    exit(1);
+}
@@ -0,0 +1,488 @@
+/*
+ * shrink_trace.c - shrink a trace that makes an allocator fail down to
+ *     a minimal reproducer
+ *
+ * Usage: shrink_trace [-j <jobs>] [-o <file>] [-m <text>] [-t <secs>]
+ *            <trace> <command> [<args>...]
+ *
+ * The command is run on candidate traces, with each "{}" argument
+ * replaced by the path of the candidate (or the path appended if no
+ * argument is "{}"), e.g.
+ *
+ *	unix> ./shrink_trace big.rep ../mdriver -a -f {}
+ *
+ * A candidate still fails if the command exits with a nonzero status,
+ * dies from a signal, or prints the text of -m (by default "ERROR",
+ * which is how mdriver reports an invalid block). A command that runs
+ * longer than the -t timeout is killed, and that candidate counts as
+ * passing.
+ *
+ * The search is delta debugging (ddmin) over the requests of the
+ * trace. It removes ever smaller chunks of requests for as long as
+ * the failure persists, until no single request can be removed.
+ * Removing the request that allocates a block removes every later
+ * request on that block, so each candidate is a consistent trace. The
+ * candidates of a round are run in parallel by up to -j processes.
+ * The result has its block and region ids renumbered from 0. The
+ * candidates live in a temporary directory, which is removed on exit
+ * and on SIGINT or SIGTERM.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define MAXLINE 256
+#define DEFAULT_TIMEOUT 60         /* seconds per run of the command */
+
+/* One request of the trace */
+typedef struct {
+    int line;                      /* offset of the request in text */
+    char type;                     /* 'a', 'r', 'f', 'x', 'g' or 'd' */
+    int id;                        /* block id (-1 for 'd') */
+    int region;                    /* region id (-1 unless 'g' or 'd') */
+    int first;                     /* is this the first request on id? */
+} req_t;
+
+static char *text;                 /* the whole trace, one line per string */
+static req_t *reqs;                /* the requests of the input trace */
+static int nreqs;
+static int num_ids;                /* from the header */
+
+/* Renumbering of ids and regions (-1: dropped) */
+static int *id_map;
+static int region_map[1024];
+
+/* The command and how to run it */
+static char **cmd;                 /* argv of the command */
+static int ncmd;
+static char *pattern = "ERROR";
+static int timeout = DEFAULT_TIMEOUT;
+static char tmpdir[] = "shrinkXXXXXX";  /* in the current directory */
+static pid_t pids[256];            /* the commands running (0: none) */
+
+static void usage(void);
+static void cleanup(void);
+static void handler(int sig);
+static void unix_error(char *msg);
+static void app_error(char *msg);
+
+/*
+ * read_trace - Read a trace file into text, and index its requests
+ */
+static void read_trace(char *path)
+{
+    FILE *fp;
+    char *line, *end, type[16];
+    long len;
+    int num_ops, *seen, n, pos;
+    req_t *r;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+	fprintf(stderr, "Could not open %s\n", path);
+	exit(1);
+    }
+    if (fseek(fp, 0, SEEK_END) < 0 || (len = ftell(fp)) < 0 ||
+	fseek(fp, 0, SEEK_SET) < 0)
+	unix_error("cannot size the trace");
+    if ((text = (char *)malloc(len + 1)) == NULL)
+	unix_error("malloc failed in read_trace");
+    if (fread(text, 1, len, fp) != (size_t)len)
+	unix_error("fread failed in read_trace");
+    text[len] = '\0';
+    fclose(fp);
+
+    pos = -1;
+    if (sscanf(text, "%*d %d %d %*d %n", &num_ids, &num_ops, &pos) != 2 ||
+	pos < 0 || num_ids < 0 || num_ops < 0)
+	app_error("bad trace header");
+    if ((reqs = (req_t *)calloc(num_ops + 1, sizeof(req_t))) == NULL ||
+	(seen = (int *)calloc(num_ids + 1, sizeof(int))) == NULL)
+	unix_error("calloc failed in read_trace");
+    nreqs = 0;
+    for (line = text + pos; nreqs < num_ops && *line != '\0'; line = end) {
+	end = line + strcspn(line, "\n");
+	if (*end != '\0')
+	    *end++ = '\0';
+	line[strcspn(line, "\r")] = '\0';
+	if (line[0] == '\0')
+	    continue;
+	r = &reqs[nreqs];
+	r->line = line - text;
+	r->id = r->region = -1;
+	if (sscanf(line, "%15s", type) != 1)
+	    app_error("bad request");
+	r->type = type[0];
+	switch (r->type) {
+	case 'g':
+	    n = sscanf(line, "%*s %d %d", &r->region, &r->id) == 2;
+	    break;
+	case 'd':
+	    n = sscanf(line, "%*s %d", &r->region) == 1;
+	    break;
+	case 'a': case 'r': case 'f': case 'x':
+	    n = sscanf(line, "%*s %d", &r->id) == 1;
+	    break;
+	default:
+	    n = 0;
+	}
+	if (!n || r->id >= num_ids || r->region >= 1024) {
+	    fprintf(stderr, "Bad request \"%s\" in %s\n", line, path);
+	    exit(1);
+	}
+	if (r->id >= 0 && !seen[r->id]) {
+	    seen[r->id] = 1;
+	    r->first = 1;
+	}
+	nreqs++;
+    }
+    free(seen);
+    if ((id_map = (int *)malloc((num_ids + 1) * sizeof(int))) == NULL)
+	unix_error("malloc failed in read_trace");
+}
+
+/*
+ * write_trace - Write the requests in keep[0..n-1] (indices into reqs,
+ *     in order) as a trace, dropping the requests on blocks whose first
+ *     request isn't kept, and renumbering ids and regions from 0.
+ *     Returns the number of requests written.
+ */
+static int write_trace(char *path, int *keep, int n)
+{
+    FILE *fp;
+    int i, ids = 0, regions = 0, count = 0, size;
+    char *line, *rest, type[16];
+    req_t *r;
+
+    memset(region_map, -1, sizeof(region_map));
+    for (i = 0; i < num_ids; i++)
+	id_map[i] = -1;
+    for (i = 0; i < n; i++) {
+	r = &reqs[keep[i]];
+	if (r->id >= 0 && r->first)
+	    id_map[r->id] = ids++;
+	if (r->id >= 0 && id_map[r->id] < 0)
+	    continue;
+	if (r->region >= 0 && region_map[r->region] < 0)
+	    region_map[r->region] = regions++;
+	count++;
+    }
+
+    if ((fp = fopen(path, "w")) == NULL)
+	unix_error("fopen failed in write_trace");
+    fprintf(fp, "%d\n%d\n%d\n1\n", 0, ids, count);
+    for (i = 0; i < n; i++) {
+	r = &reqs[keep[i]];
+	if (r->id >= 0 && id_map[r->id] < 0)
+	    continue;
+	line = text + r->line;
+	sscanf(line, "%15s", type);
+	switch (r->type) {
+	case 'g':
+	    sscanf(line, "%*s %*d %*d %d", &size);
+	    fprintf(fp, "%s %d %d %d\n", type, region_map[r->region],
+		    id_map[r->id], size);
+	    break;
+	case 'd':
+	    fprintf(fp, "%s %d\n", type, region_map[r->region]);
+	    break;
+	default: /* the id, then whatever followed it */
+	    rest = line + strspn(line, " \t");
+	    rest += strcspn(rest, " \t");
+	    rest += strspn(rest, " \t");
+	    rest += strcspn(rest, " \t");
+	    fprintf(fp, "%s %d%s\n", type, id_map[r->id], rest);
+	    break;
+	}
+    }
+    fclose(fp);
+    return count;
+}
+
+/*
+ * now - Wall clock time in seconds
+ */
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/*
+ * start - Run the command on the trace at path in the background, with
+ *     its output going to path.out. Returns the pid.
+ */
+static pid_t start(char *path)
+{
+    char out[MAXLINE], **argv;
+    int i, k = 0, subst = 0;
+    pid_t pid;
+
+    if ((argv = (char **)malloc((ncmd + 2) * sizeof(char *))) == NULL)
+	unix_error("malloc failed in start");
+    for (i = 0; i < ncmd; i++)
+	if (!strcmp(cmd[i], "{}")) {
+	    argv[k++] = path;
+	    subst = 1;
+	}
+	else
+	    argv[k++] = cmd[i];
+    if (!subst)
+	argv[k++] = path;
+    argv[k] = NULL;
+    sprintf(out, "%s.out", path);
+
+    if ((pid = fork()) < 0)
+	unix_error("fork failed in start");
+    if (pid == 0) {
+	if (freopen(out, "w", stdout) == NULL ||
+	    dup2(fileno(stdout), 2) < 0)
+	    _exit(127);
+	execvp(argv[0], argv);
+	fprintf(stderr, "shrink_trace: cannot run %s\n", argv[0]);
+	_exit(127);
+    }
+    free(argv);
+    return pid;
+}
+
+/*
+ * fails - Did the run of pid on the trace at path reproduce the failure?
+ *     A pid of 0 stands for an empty trace, which never fails. If the
+ *     run is still going at time deadline, it is killed and passes.
+ */
+static int fails(pid_t pid, char *path, double deadline)
+{
+    char out[MAXLINE], line[1024];
+    FILE *fp;
+    int status, found = 0;
+    pid_t done;
+
+    if (pid == 0)
+	return 0;
+    while ((done = waitpid(pid, &status, WNOHANG)) == 0) {
+	if (now() >= deadline) {
+	    kill(pid, SIGKILL);
+	    waitpid(pid, &status, 0);
+	    return 0;
+	}
+	usleep(1000);
+    }
+    if (done < 0)
+	unix_error("waitpid failed in fails");
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127)
+	app_error("the command could not be run");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	return 1;
+    sprintf(out, "%s.out", path);
+    if ((fp = fopen(out, "r")) == NULL)
+	return 0;
+    while (!found && fgets(line, sizeof(line), fp) != NULL)
+	found = strstr(line, pattern) != NULL;
+    fclose(fp);
+    return found;
+}
+
+/*
+ * try_removals - Try to remove each of the nchunks chunks of keep[]
+ *     (n requests), running up to jobs candidates at a time. On the
+ *     first chunk (in order) whose removal still fails, shrink keep[]
+ *     and return 1.
+ */
+static int try_removals(int *keep, int *n, int nchunks, int jobs, int *cand)
+{
+    char path[MAXLINE];
+    int lo[256], hi[256];
+    int base, c, i, m, hit = -1;
+    double deadline;
+
+    for (base = 0; base < nchunks && hit < 0; base += jobs) {
+	for (c = base; c < nchunks && c < base + jobs; c++) {
+	    lo[c - base] = (long)c * *n / nchunks;
+	    hi[c - base] = (long)(c + 1) * *n / nchunks;
+	    for (m = 0, i = 0; i < *n; i++)
+		if (i < lo[c - base] || i >= hi[c - base])
+		    cand[m++] = keep[i];
+	    sprintf(path, "%s/c%d.rep", tmpdir, c - base);
+	    pids[c - base] = write_trace(path, cand, m) ? start(path) : 0;
+	}
+	deadline = now() + timeout;
+	for (c = base; c < nchunks && c < base + jobs; c++) {
+	    sprintf(path, "%s/c%d.rep", tmpdir, c - base);
+	    if (fails(pids[c - base], path, deadline) && hit < 0)
+		hit = c - base;
+	    pids[c - base] = 0;
+	}
+    }
+    if (hit < 0)
+	return 0;
+    for (m = 0, i = 0; i < *n; i++)
+	if (i < lo[hit] || i >= hi[hit])
+	    keep[m++] = keep[i];
+    *n = m;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int c, i, n, nchunks, jobs, *keep, *cand;
+    char *outfile = NULL, path[MAXLINE];
+
+    jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    while ((c = getopt(argc, argv, "+hj:o:m:t:")) != EOF) {
+	switch (c) {
+	case 'j': /* Number of parallel runs */
+	    jobs = atoi(optarg);
+	    break;
+	case 'o': /* Output file */
+	    outfile = optarg;
+	    break;
+	case 'm': /* Output that marks a failure */
+	    pattern = optarg;
+	    break;
+	case 't': /* Timeout of one run */
+	    timeout = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (argc - optind < 2 || timeout < 1) {
+	usage();
+	exit(1);
+    }
+    if (jobs < 1)
+	jobs = 1;
+    if (jobs > 256)
+	jobs = 256;
+    read_trace(argv[optind]);
+    cmd = &argv[optind + 1];
+    ncmd = argc - optind - 1;
+    if (outfile == NULL) {
+	if ((outfile = malloc(strlen(argv[optind]) + 5)) == NULL)
+	    unix_error("malloc failed in main");
+	sprintf(outfile, "%s.min", argv[optind]);
+    }
+    if (mkdtemp(tmpdir) == NULL)
+	unix_error("mkdtemp failed");
+    atexit(cleanup);
+    signal(SIGINT, handler);
+    signal(SIGTERM, handler);
+
+    if ((keep = (int *)malloc((nreqs + 1) * sizeof(int))) == NULL ||
+	(cand = (int *)malloc((nreqs + 1) * sizeof(int))) == NULL)
+	unix_error("malloc failed in main");
+    for (i = 0; i < nreqs; i++)
+	keep[i] = i;
+    n = nreqs;
+
+    /* The whole trace must fail to begin with */
+    sprintf(path, "%s/c0.rep", tmpdir);
+    write_trace(path, keep, n);
+    pids[0] = start(path);
+    if (!fails(pids[0], path, now() + timeout)) {
+	fprintf(stderr, "shrink_trace: %s does not fail\n", argv[optind]);
+	exit(1);
+    }
+    pids[0] = 0;
+
+    /* ddmin: remove chunks while that keeps the failure, else refine */
+    nchunks = 2;
+    while (n >= 2) {
+	if (nchunks > n)
+	    nchunks = n;
+	if (try_removals(keep, &n, nchunks, jobs, cand)) {
+	    fprintf(stderr, "shrink_trace: %d requests\n", n);
+	    if (nchunks > 2)
+		nchunks--;
+	}
+	else if (nchunks == n)
+	    break;                 /* no single request can go */
+	else
+	    nchunks *= 2;
+    }
+
+    n = write_trace(outfile, keep, n);
+    printf("Wrote %d of %d requests to %s\n", n, nreqs, outfile);
+    return 0;
+}
+
+/*
+ * cleanup - Remove the candidates and their output
+ */
+static void cleanup(void)
+{
+    char path[MAXLINE];
+    int i;
+
+    for (i = 0; i < 256; i++) {
+	sprintf(path, "%s/c%d.rep", tmpdir, i);
+	unlink(path);
+	strcat(path, ".out");
+	unlink(path);
+    }
+    rmdir(tmpdir);
+}
+
+/*
+ * handler - On SIGINT or SIGTERM, stop the running commands and remove
+ *     the candidates before dying from the signal
+ */
+static void handler(int sig)
+{
+    int i;
+
+    for (i = 0; i < 256; i++)
+	if (pids[i] > 0) {
+	    kill(pids[i], SIGKILL);
+	    waitpid(pids[i], NULL, 0);
+	}
+    cleanup();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+    fprintf(stderr, "Usage: shrink_trace [-h] [-j <jobs>] [-o <file>] [-m <text>] [-t <secs>]\n");
+    fprintf(stderr, "                    <trace> <command> [<args>...]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-j <jobs>  Run <jobs> commands at a time (default: number of CPUs).\n");
+    fprintf(stderr, "\t-m <text>  Output that marks a failure (default \"ERROR\").\n");
+    fprintf(stderr, "\t-o <file>  Write the result to <file> (default <trace>.min).\n");
+    fprintf(stderr, "\t-t <secs>  Kill a command after <secs> seconds (default %d).\n",
+	    DEFAULT_TIMEOUT);
+    fprintf(stderr, "An argument {} of the command is replaced by the candidate trace.\n");
+}
+
+/*
+ * unix_error - Report a Unix-style error and exit
+ */
+static void unix_error(char *msg)
+{
+    perror(msg);
+    exit(1);
+}
+
+/*
+ * app_error - Report an error and exit
+ */
+static void app_error(char *msg)
+{
+    fprintf(stderr, "shrink_trace: %s\n", msg);
+    exit(1);
+}